@@ -0,0 +1,240 @@
+#include "nvgen.h"
+#include "../src/tokenizer/tokenize.h"
+#include "../src/parser/parser.h"
+#include "../src/analysis/analysis.h"
+#include "../src/llvm/llvm_generator.h"
+#include "../src/optimizer/optimizer.h"
+#include "../src/optimizer/fold.h"
+#include "../src/target/target.h"
+#include "../src/driver/parallel_codegen.h"
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs every compiler phase over a generated program several times and reports
+// throughput per phase. Compares against a stored baseline to catch regressions.
+
+namespace {
+
+const char* const PHASES[] = {"tokenize", "parse", "analyze", "fold", "codegen", "optimize", "emit"};
+
+struct Samples {
+    std::vector<double> ms;
+
+    double median() const {
+        std::vector<double> sorted = ms;
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    }
+    double min() const { return *std::min_element(ms.begin(), ms.end()); }
+    double mean() const {
+        double sum = 0;
+        for (double v : ms) sum += v;
+        return sum / ms.size();
+    }
+    double stddev() const {
+        double m = mean(), sum = 0;
+        for (double v : ms) sum += (v - m) * (v - m);
+        return ms.size() > 1 ? std::sqrt(sum / (ms.size() - 1)) : 0;
+    }
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Function to run the pipeline once, recording the time of each phase
+ */
+void runOnce(const std::string& source, OptLevel level, unsigned codegenThreads, std::map<std::string, Samples>& samples,
+             size_t& tokenCount) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Token> tokens = tokenize(source);
+    samples["tokenize"].ms.push_back(millisecondsSince(start));
+    tokenCount = tokens.size();
+
+    // the parser lexes on demand, so this phase covers lexing again
+    Arena arena;
+    start = std::chrono::steady_clock::now();
+    Lexer lexer(source);
+    DiagnosticEngine diagnostics("bench", source);
+    Parser parser(lexer, arena, diagnostics);
+    ASTNode* ast = parser.parse();
+    samples["parse"].ms.push_back(millisecondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    SymbolTable symbolTable;
+    semanticAnalysis(ast, symbolTable, diagnostics);
+    samples["analyze"].ms.push_back(millisecondsSince(start));
+    if (diagnostics.hasErrors()) {
+        diagnostics.print(std::cerr);
+        throw CompileError("input has errors");
+    }
+
+    start = std::chrono::steady_clock::now();
+    foldConstants(ast, symbolTable);
+    samples["fold"].ms.push_back(millisecondsSince(start));
+
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> module;
+    std::unique_ptr<llvm::TargetMachine> targetMachine;
+    if (codegenThreads > 1) {
+        // partitions are cleaned up while they are generated, the linked module runs the pipeline
+        start = std::chrono::steady_clock::now();
+        context = std::make_unique<llvm::LLVMContext>();
+        module = generateInParallel(ast, symbolTable, *context, codegenThreads, level);
+        samples["codegen"].ms.push_back(millisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        targetMachine = createHostTargetMachine(level);
+        configureModuleForTarget(*module, *targetMachine);
+        cleanupFunctions(*module, level);
+        optimizeModule(*module, level, targetMachine.get(), false);
+        samples["optimize"].ms.push_back(millisecondsSince(start));
+    } else {
+        start = std::chrono::steady_clock::now();
+        CodeGenerator generator;
+        generator.generate(ast, symbolTable);
+        context = generator.takeContext();
+        module = generator.takeModule();
+        samples["codegen"].ms.push_back(millisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        targetMachine = createHostTargetMachine(level);
+        configureModuleForTarget(*module, *targetMachine);
+        cleanupFunctions(*module, level);
+        optimizeModule(*module, level, targetMachine.get(), false);
+        samples["optimize"].ms.push_back(millisecondsSince(start));
+    }
+
+    start = std::chrono::steady_clock::now();
+    llvm::SmallVector<char, 0> object;
+    llvm::raw_svector_ostream objectStream(object);
+    llvm::legacy::PassManager passes;
+    targetMachine->addPassesToEmitFile(passes, objectStream, nullptr, llvm::CGFT_ObjectFile);
+    passes.run(*module);
+    samples["emit"].ms.push_back(millisecondsSince(start));
+}
+
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string phase;
+        double mbPerSecond;
+        if (fields >> phase >> mbPerSecond) baseline[phase] = mbPerSecond;
+    }
+    return baseline;
+}
+
+void usage() {
+    std::cerr << "Usage: bench [generator flags] [--repeat=N] [-O0..-O3] [--codegen-threads=N] [--baseline=file] [--save-baseline=file]\n"
+              << "             [--tolerance=percent] [--input=file.nv]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    GeneratorConfig config;
+    unsigned repeat = 5;
+    unsigned codegenThreads = 1;
+    OptLevel level = OptLevel::O2;
+    std::string baselinePath, savePath, inputPath;
+    double tolerance = 25;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (parseGeneratorFlag(arg, config)) continue;
+        if (arg.rfind("--repeat=", 0) == 0) repeat = std::max(1ul, std::strtoul(arg.c_str() + 9, nullptr, 10));
+        else if (arg.rfind("--codegen-threads=", 0) == 0) codegenThreads = std::strtoul(arg.c_str() + 18, nullptr, 10);
+        else if (arg == "-O0") level = OptLevel::O0;
+        else if (arg == "-O1") level = OptLevel::O1;
+        else if (arg == "-O2") level = OptLevel::O2;
+        else if (arg == "-O3") level = OptLevel::O3;
+        else if (arg.rfind("--baseline=", 0) == 0) baselinePath = arg.substr(11);
+        else if (arg.rfind("--save-baseline=", 0) == 0) savePath = arg.substr(16);
+        else if (arg.rfind("--tolerance=", 0) == 0) tolerance = std::strtod(arg.c_str() + 12, nullptr);
+        else if (arg.rfind("--input=", 0) == 0) inputPath = arg.substr(8);
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::string source;
+    if (!inputPath.empty()) {
+        std::ifstream file(inputPath, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        source = content.str();
+    } else {
+        source = generateProgram(config);
+    }
+    double megabytes = source.size() / (1024.0 * 1024.0);
+
+    std::map<std::string, Samples> samples;
+    size_t tokenCount = 0;
+    try {
+        runOnce(source, level, codegenThreads, samples, tokenCount); // warm-up, not recorded
+        samples.clear();
+        for (unsigned i = 0; i < repeat; ++i) {
+            runOnce(source, level, codegenThreads, samples, tokenCount);
+        }
+    } catch (const CompileError& error) {
+        std::cerr << "bench: " << error.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "input: " << source.size() << " bytes, " << tokenCount << " tokens, " << repeat << " runs\n";
+    std::cout << std::left << std::setw(10) << "phase" << std::right << std::setw(11) << "median ms" << std::setw(10)
+              << "min ms" << std::setw(10) << "stddev" << std::setw(10) << "MB/s" << std::setw(14) << "tokens/s"
+              << "\n"
+              << std::fixed;
+
+    std::map<std::string, double> throughput;
+    for (const char* phase : PHASES) {
+        const Samples& s = samples[phase];
+        double seconds = s.median() / 1000.0;
+        throughput[phase] = megabytes / seconds;
+        std::cout << std::left << std::setw(10) << phase << std::right << std::setprecision(3) << std::setw(11)
+                  << s.median() << std::setw(10) << s.min() << std::setw(10) << s.stddev() << std::setprecision(2)
+                  << std::setw(10) << throughput[phase] << std::setprecision(0) << std::setw(14)
+                  << tokenCount / seconds << "\n";
+    }
+
+    if (!savePath.empty()) {
+        std::ofstream out(savePath);
+        out << "# cts benchmark baseline: median MB/s per phase\n" << std::fixed << std::setprecision(2);
+        for (const char* phase : PHASES) out << phase << " " << throughput[phase] << "\n";
+        std::cout << "baseline saved to " << savePath << "\n";
+    }
+
+    int status = 0;
+    if (!baselinePath.empty()) {
+        std::map<std::string, double> baseline = readBaseline(baselinePath);
+        for (const char* phase : PHASES) {
+            auto it = baseline.find(phase);
+            if (it == baseline.end() || it->second <= 0) continue;
+            double change = (throughput[phase] / it->second - 1) * 100;
+            bool regressed = change < -tolerance;
+            std::cout << std::setprecision(1) << phase << ": " << std::showpos << change << std::noshowpos
+                      << "% vs baseline" << (regressed ? "  REGRESSION" : "") << "\n";
+            if (regressed) status = 1;
+        }
+    }
+    return status;
+}
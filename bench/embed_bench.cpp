@@ -0,0 +1,128 @@
+#include "../src/nova/nova.h"
+#include "../src/logger/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Embedding benchmark: compiles many small rule sources in one process through libnova, the way
+// a host using the language as a rule engine would, and checks every loaded rule's result.
+
+namespace {
+
+constexpr int RULES_PER_BATCH = 50;
+
+/**
+ * @brief Function to generate a rule with its own threshold and weights
+ */
+std::string ruleFunction(int i, const std::string& name) {
+    return "fn " + name + "(x: int, y: int) {\n"
+           "    let s: int = x * " + std::to_string(i % 7 + 1) + " + y;\n"
+           "    if (s > " + std::to_string(i) + ") { return 1; }\n"
+           "    return 0;\n"
+           "}\n";
+}
+
+std::string ruleSource(int i) {
+    return ruleFunction(i, "score") + "fn main() { return score(" + std::to_string(i) + ", 1); }\n";
+}
+
+int32_t expectedScore(int i, int32_t x, int32_t y) {
+    return x * (i % 7 + 1) + y > i ? 1 : 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* phase, int rules, double seconds) {
+    std::cout << std::left << std::setw(10) << phase << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << rules / seconds << " rules/s" << std::setw(10) << seconds * 1e6 / rules
+              << " us/rule\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int count = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--sources=", 0) == 0) {
+            count = std::atoi(arg.c_str() + 10);
+        } else {
+            std::cerr << "Usage: embed_bench [--sources=N]\n";
+            return 1;
+        }
+    }
+    log::setLevel(LogLevel::NONE);
+
+    std::vector<std::string> sources;
+    for (int i = 0; i < count; ++i) {
+        sources.push_back(ruleSource(i));
+    }
+
+    nova::Compiler compiler;
+    bool failed = false;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& source : sources) {
+        failed |= !compiler.check(source).empty();
+    }
+    report("check", count, secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    for (const std::string& source : sources) {
+        failed |= !compiler.compile(source, EmitKind::LLVM).ok();
+    }
+    report("compile", count, secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        nova::Program program = compiler.load(sources[i]);
+        auto score = program.function<int32_t(int32_t, int32_t)>("score");
+        int32_t result = 0;
+        if (!program.ok() || !score || score(i / 2, 3) != expectedScore(i, i / 2, 3) || !program.runMain(result) ||
+            result != expectedScore(i, i, 1)) {
+            std::cerr << "Rule " << i << " failed\n" << program.diagnostics().text;
+            failed = true;
+            break;
+        }
+    }
+    report("load+run", count, secondsSince(start));
+
+    // the backend's cost is per source, rules loaded together share it
+    start = std::chrono::steady_clock::now();
+    for (int first = 0; first < count && !failed; first += RULES_PER_BATCH) {
+        int last = std::min(count, first + RULES_PER_BATCH);
+        std::string batch;
+        for (int i = first; i < last; ++i) {
+            batch += ruleFunction(i, "score" + std::to_string(i));
+        }
+        nova::Program program = compiler.load(batch);
+        for (int i = first; i < last; ++i) {
+            auto score = program.function<int32_t(int32_t, int32_t)>("score" + std::to_string(i));
+            if (!score || score(i / 2, 3) != expectedScore(i, i / 2, 3)) {
+                std::cerr << "Batched rule " << i << " failed\n" << program.diagnostics().text;
+                failed = true;
+                break;
+            }
+        }
+    }
+    report("batched", count, secondsSince(start));
+
+    nova::Artifact broken = compiler.compile("fn main() { return x; }", EmitKind::LLVM);
+    if (broken.ok() || broken.diagnostics.errors.size() != 1 || broken.diagnostics.errors[0].line != 1) {
+        std::cerr << "Errors of a broken source were not reported\n";
+        failed = true;
+    }
+
+    if (failed) {
+        std::cerr << "FAILED\n";
+        return 1;
+    }
+    return 0;
+}
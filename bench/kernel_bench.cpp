@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Kernel benchmark: times loops compiled by cts (bench/kernels.nv, built with -O3 for the
+// host CPU) against the same loops in C++ built by the host compiler with -O3 -march=native
+// and the same vector width, so the vectorized code cts emits for arrays can be compared with native C.
+
+namespace {
+
+constexpr size_t KERNEL_LENGTH = 16384; // elements per array, 64 KB stays in L2
+constexpr int ROUNDS = 5;
+
+using Array = int32_t[KERNEL_LENGTH];
+
+// arrays are passed by reference and must be as aligned as cts assumes
+alignas(64) Array a, b, y;
+volatile int32_t sink; // results are stored, so the calls are not removed as unused
+
+} // namespace
+
+extern "C" {
+int32_t nv_sum(Array* a);
+int32_t nv_dot(Array* a, Array* b);
+int32_t nv_axpy(Array* y, Array* x, int32_t k);
+}
+
+namespace {
+
+// unsigned arithmetic wraps like the i32 instructions cts emits
+__attribute__((noinline)) int32_t c_sum(const int32_t* __restrict a) {
+    uint32_t s = 0;
+    for (size_t i = 0; i < KERNEL_LENGTH; ++i) s += static_cast<uint32_t>(a[i]);
+    return static_cast<int32_t>(s);
+}
+
+__attribute__((noinline)) int32_t c_dot(const int32_t* __restrict a, const int32_t* __restrict b) {
+    uint32_t s = 0;
+    for (size_t i = 0; i < KERNEL_LENGTH; ++i) s += static_cast<uint32_t>(a[i]) * static_cast<uint32_t>(b[i]);
+    return static_cast<int32_t>(s);
+}
+
+__attribute__((noinline)) int32_t c_axpy(int32_t* __restrict y, const int32_t* __restrict x, int32_t k) {
+    for (size_t i = 0; i < KERNEL_LENGTH; ++i) {
+        y[i] = static_cast<int32_t>(static_cast<uint32_t>(y[i]) + static_cast<uint32_t>(k) * static_cast<uint32_t>(x[i]));
+    }
+    return 0;
+}
+
+/**
+ * @brief Function to time a kernel, the best of several rounds of calls
+ * @return Nanoseconds per call
+ */
+template <typename Kernel>
+double timeKernel(Kernel kernel, int calls) {
+    double best = 1e300;
+    for (int round = 0; round < ROUNDS; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) {
+            // the arrays may have changed, keeps the compiler from hoisting a call out of the loop
+            asm volatile("" : : : "memory");
+            sink = kernel();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / calls);
+    }
+    return best;
+}
+
+void fill() {
+    uint32_t state = 12345;
+    for (size_t i = 0; i < KERNEL_LENGTH; ++i) {
+        state = state * 1664525u + 1013904223u;
+        a[i] = static_cast<int32_t>(state >> 8) - (1 << 23);
+        b[i] = static_cast<int32_t>(state % 1000) - 500;
+        y[i] = static_cast<int32_t>(i);
+    }
+}
+
+struct Result {
+    const char* name;
+    double nova;
+    double native;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int calls = 20000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--calls=", 0) == 0) {
+            calls = std::max(1, std::atoi(arg.c_str() + 8));
+        } else {
+            std::cerr << "usage: kernel_bench [--calls=N]\n";
+            return 1;
+        }
+    }
+
+    fill();
+    if (nv_sum(&a) != c_sum(a) || nv_dot(&a, &b) != c_dot(a, b)) {
+        std::cerr << "kernel results differ between cts and C++\n";
+        return 1;
+    }
+    nv_axpy(&y, &b, 3);
+    std::vector<int32_t> expected(y, y + KERNEL_LENGTH);
+    fill();
+    c_axpy(y, b, 3);
+    if (!std::equal(expected.begin(), expected.end(), y)) {
+        std::cerr << "kernel results differ between cts and C++\n";
+        return 1;
+    }
+
+    std::vector<Result> results = {
+        {"sum", timeKernel([] { return nv_sum(&a); }, calls), timeKernel([] { return c_sum(a); }, calls)},
+        {"dot", timeKernel([] { return nv_dot(&a, &b); }, calls), timeKernel([] { return c_dot(a, b); }, calls)},
+        {"axpy", timeKernel([] { return nv_axpy(&y, &b, 3); }, calls), timeKernel([] { return c_axpy(y, b, 3); }, calls)},
+    };
+
+    std::cout << KERNEL_LENGTH << " ints per array, best of " << ROUNDS << " rounds of " << calls << " calls\n";
+    std::cout << std::left << std::setw(8) << "kernel" << std::right << std::setw(12) << "cts ns" << std::setw(12)
+              << "C++ ns" << std::setw(14) << "cts elem/ns" << std::setw(10) << "cts/C++" << "\n";
+    std::cout << std::fixed;
+    for (const Result& result : results) {
+        std::cout << std::left << std::setw(8) << result.name << std::right << std::setprecision(0) << std::setw(12)
+                  << result.nova << std::setw(12) << result.native << std::setprecision(2) << std::setw(14)
+                  << KERNEL_LENGTH / result.nova << std::setw(10) << result.native / result.nova << "\n";
+    }
+    return 0;
+}
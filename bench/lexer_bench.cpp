@@ -0,0 +1,145 @@
+#include "nvgen.h"
+#include "../src/tokenizer/tokenize.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Lexer microbenchmark: times tokenize() against the previous hash-map based
+// lexer on the same generated input and checks that both agree token for token.
+
+namespace {
+
+const std::unordered_map<std::string_view, TokenType> LEGACY_KEYWORDS = {
+    {"fn", TokenType::KEYWORD},
+    {"let", TokenType::KEYWORD},
+    {"return", TokenType::KEYWORD},
+    {"int", TokenType::KEYWORD}
+};
+
+const std::unordered_map<char, TokenType> LEGACY_SYMBOLS = {
+    {'=', TokenType::SYMBOL}, {'+', TokenType::SYMBOL}, {'-', TokenType::SYMBOL}, {'*', TokenType::SYMBOL},
+    {'/', TokenType::SYMBOL}, {'(', TokenType::SYMBOL}, {')', TokenType::SYMBOL}, {'{', TokenType::SYMBOL},
+    {'}', TokenType::SYMBOL}, {',', TokenType::SYMBOL}, {':', TokenType::SYMBOL}, {';', TokenType::SYMBOL}
+};
+
+/**
+ * @brief Function to tokenize the way the lexer did before the table-driven rewrite
+ */
+void legacyTokenize(std::string_view content, std::vector<Token>& tokens) {
+    tokens.clear();
+    tokens.reserve(content.length() / 4);
+    int line = 1, column = 1;
+
+    for (size_t i = 0; i < content.length(); ++i) {
+        char c = content[i];
+        if (c == '/' && i + 1 < content.length() && content[i + 1] == '/') {
+            while (i < content.length() && content[i] != '\n') i++;
+            line++;
+            column = 1;
+            continue;
+        }
+        if (std::isspace(c)) {
+            if (c == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
+            }
+            continue;
+        }
+        if (LEGACY_SYMBOLS.count(c)) {
+            tokens.push_back({LEGACY_SYMBOLS.at(c), content.substr(i, 1), line, column});
+            column++;
+            continue;
+        }
+        if (std::isalpha(c) || c == '_') {
+            size_t start = i;
+            while (i + 1 < content.length() && (std::isalnum(content[i + 1]) || content[i + 1] == '_')) ++i;
+            std::string_view identifier = content.substr(start, i - start + 1);
+            auto keyword = LEGACY_KEYWORDS.find(identifier);
+            TokenType type = keyword != LEGACY_KEYWORDS.end() ? keyword->second : TokenType::IDENTIFIER;
+            tokens.push_back({type, identifier, line, column});
+            column += identifier.length();
+            continue;
+        }
+        if (std::isdigit(c)) {
+            size_t start = i;
+            while (i + 1 < content.length() && std::isdigit(content[i + 1])) ++i;
+            std::string_view number = content.substr(start, i - start + 1);
+            tokens.push_back({TokenType::NUMBER, number, line, column});
+            column += number.length();
+            continue;
+        }
+        tokens.push_back({TokenType::UNKNOWN, content.substr(i, 1), line, column});
+        column++;
+    }
+}
+
+// the output vector is reused so page faults on fresh token storage stay out of the numbers
+template <typename Lexer>
+double bestMilliseconds(Lexer lexer, std::string_view source, unsigned repeat, std::vector<Token>& tokens) {
+    double best = 1e300;
+    for (unsigned i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        lexer(source, tokens);
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+bool sameTokens(const std::vector<Token>& a, const std::vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].type != b[i].type || a[i].value != b[i].value || a[i].line != b[i].line ||
+            a[i].column != b[i].column) {
+            std::cerr << "mismatch at token " << i << ": " << a[i].to_string() << " vs " << b[i].to_string() << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    GeneratorConfig config;
+    config.lets = 50000;
+    unsigned repeat = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (parseGeneratorFlag(arg, config)) continue;
+        if (arg.rfind("--repeat=", 0) == 0) {
+            repeat = std::max(1ul, std::strtoul(arg.c_str() + 9, nullptr, 10));
+            continue;
+        }
+        std::cerr << "Usage: lexer_bench [generator flags] [--repeat=N]\n";
+        return 1;
+    }
+
+    // comments and tabs exercise the paths the generator does not produce
+    std::string source = "// generated lexer benchmark input\n\t\r\n" + generateProgram(config);
+    double megabytes = source.size() / (1024.0 * 1024.0);
+
+    std::vector<Token> legacyTokens, currentTokens;
+    double legacy = bestMilliseconds(legacyTokenize, source, repeat, legacyTokens);
+    double current = bestMilliseconds(static_cast<void (*)(std::string_view, std::vector<Token>&)>(tokenize), source,
+                                      repeat, currentTokens);
+    if (!sameTokens(currentTokens, legacyTokens)) return 1;
+    size_t count = currentTokens.size();
+
+    std::cout << "input: " << source.size() << " bytes, " << count << " tokens\n" << std::fixed;
+    std::cout << std::setprecision(2) << "legacy:  " << std::setw(9) << legacy << " ms " << std::setw(9)
+              << megabytes / (legacy / 1000) << " MB/s " << std::setprecision(0) << std::setw(12)
+              << count / (legacy / 1000) << " tokens/s\n";
+    std::cout << std::setprecision(2) << "current: " << std::setw(9) << current << " ms " << std::setw(9)
+              << megabytes / (current / 1000) << " MB/s " << std::setprecision(0) << std::setw(12)
+              << count / (current / 1000) << " tokens/s\n";
+    std::cout << std::setprecision(2) << "speedup: " << legacy / current << "x\n";
+    return 0;
+}
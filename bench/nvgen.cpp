@@ -0,0 +1,139 @@
+#include "nvgen.h"
+#include <cstdlib>
+
+namespace {
+
+class Generator {
+public:
+    Generator(const GeneratorConfig& config) : config(config), state(config.seed ? config.seed : 1) {}
+
+    std::string run() {
+        out.reserve(static_cast<size_t>(config.functions) * config.lets * 24 * (config.width + 1) * config.depth);
+        for (unsigned f = 0; f < config.functions; ++f) {
+            function(f);
+        }
+        return out;
+    }
+
+private:
+    uint64_t next() {
+        // xorshift64, deterministic for a given seed
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    unsigned below(unsigned bound) { return static_cast<unsigned>(next() % bound); }
+
+    void function(unsigned index) {
+        out += "fn ";
+        out += index == 0 ? std::string("main") : "f" + std::to_string(index);
+        // functions other than main take parameters, so their bodies do not fold to a constant
+        hasParameters = index != 0;
+        out += hasParameters ? "(a: int, b: int) {\n" : "() {\n";
+
+        variables = 0;
+        for (unsigned i = 0; i < config.lets; ++i) {
+            out += "    let v" + std::to_string(variables) + ": int = ";
+            expression(config.depth);
+            out += ";\n";
+            ++variables;
+        }
+
+        if (config.nesting) {
+            out += "    let v" + std::to_string(variables) + ": int = ";
+            for (unsigned i = 0; i < config.nesting; ++i) out += '(';
+            operand();
+            for (unsigned i = 0; i < config.nesting; ++i) {
+                out += " + ";
+                out += std::to_string(below(100));
+                out += ')';
+            }
+            out += ";\n";
+            ++variables;
+        }
+
+        if (index == 0) {
+            for (unsigned callee = 1; callee < config.functions; ++callee) {
+                out += "    let v" + std::to_string(variables) + ": int = f" + std::to_string(callee) + "(";
+                operand();
+                out += ", ";
+                operand();
+                out += ");\n";
+                ++variables;
+            }
+        }
+
+        out += "    return ";
+        if (variables >= 2) {
+            out += "v" + std::to_string(variables - 1) + " + v" + std::to_string(variables - 2);
+        } else {
+            out += variables ? "v" + std::to_string(variables - 1) : std::string("0");
+        }
+        out += ";\n}\n\n";
+    }
+
+    void operand() {
+        if (hasParameters && below(4) == 0) {
+            out += below(2) ? 'a' : 'b';
+        } else if (variables && below(2)) {
+            out += 'v';
+            out += std::to_string(below(variables));
+        } else {
+            out += std::to_string(below(1000));
+        }
+    }
+
+    void expression(unsigned depth) {
+        for (unsigned i = 0; i < config.width; ++i) {
+            if (i) {
+                // division only by non-zero literals so the program is valid at every stage
+                switch (below(4)) {
+                    case 0: out += " + "; break;
+                    case 1: out += " - "; break;
+                    case 2: out += " * "; break;
+                    case 3: out += " / " + std::to_string(1 + below(9)); continue;
+                }
+            }
+            if (depth > 1 && below(2)) {
+                out += '(';
+                expression(depth - 1);
+                out += ')';
+            } else {
+                operand();
+            }
+        }
+    }
+
+    const GeneratorConfig& config;
+    uint64_t state;
+    unsigned variables = 0;
+    bool hasParameters = false;
+    std::string out;
+};
+
+bool numericFlag(const std::string& arg, const char* name, uint64_t& value) {
+    std::string prefix = std::string("--") + name + "=";
+    if (arg.rfind(prefix, 0) != 0) return false;
+    value = std::strtoull(arg.c_str() + prefix.size(), nullptr, 10);
+    return true;
+}
+
+} // namespace
+
+std::string generateProgram(const GeneratorConfig& config) {
+    return Generator(config).run();
+}
+
+bool parseGeneratorFlag(const std::string& arg, GeneratorConfig& config) {
+    uint64_t value;
+    if (numericFlag(arg, "functions", value)) config.functions = value;
+    else if (numericFlag(arg, "lets", value)) config.lets = value;
+    else if (numericFlag(arg, "depth", value)) config.depth = value;
+    else if (numericFlag(arg, "width", value)) config.width = value;
+    else if (numericFlag(arg, "nesting", value)) config.nesting = value;
+    else if (numericFlag(arg, "seed", value)) config.seed = value;
+    else return false;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef NVGEN_H
+#define NVGEN_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Shape of a synthetic program
+ */
+struct GeneratorConfig {
+    unsigned functions = 1;  // number of functions; the first is main and calls the others, which take two parameters
+    unsigned lets = 1000;    // let statements per function
+    unsigned depth = 3;      // parenthesis nesting levels per initializer
+    unsigned width = 4;      // terms per nesting level
+    unsigned nesting = 200;  // depth of one extra, deeply parenthesized initializer per function
+    uint64_t seed = 1;
+};
+
+/**
+ * @brief Function to generate a synthetic .nv program
+ * @param config Program shape
+ * @return Source text
+ */
+std::string generateProgram(const GeneratorConfig& config);
+
+/**
+ * @brief Function to parse a generator flag such as --lets=500
+ * @param arg Command line argument
+ * @param config Config to update
+ * @return false if arg is not a generator flag
+ */
+bool parseGeneratorFlag(const std::string& arg, GeneratorConfig& config);
+
+#endif // NVGEN_H
@@ -0,0 +1,14 @@
+#include "nvgen.h"
+#include <iostream>
+
+int main(int argc, char** argv) {
+    GeneratorConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (!parseGeneratorFlag(argv[i], config)) {
+            std::cerr << "Usage: nvgen [--functions=N] [--lets=N] [--depth=N] [--width=N] [--nesting=N] [--seed=N]\n";
+            return 1;
+        }
+    }
+    std::cout << generateProgram(config);
+    return 0;
+}
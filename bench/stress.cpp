@@ -0,0 +1,309 @@
+#include "../src/parser/parser.h"
+#include "../src/analysis/analysis.h"
+#include "../src/optimizer/fold.h"
+#include "../src/interp/bytecode.h"
+#include "../src/interp/interpreter.h"
+#include "../src/llvm/llvm_generator.h"
+#include "../src/nova/nova.h"
+#include "../src/logger/logger.h"
+#include <llvm/IR/Verifier.h>
+#include <pthread.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stress test for machine-generated input: expressions of a million terms, a million nested
+// parentheses and a million nested array indexes go through every phase, from parsing to
+// native code, on a thread with a small stack. Checks each result and that the time grows
+// linearly with the size of the expression.
+
+namespace {
+
+// far below the default 8 MB, a phase that recursed per term would overflow it within a few thousand
+constexpr size_t STRESS_STACK_BYTES = 1 << 20;
+// a tenth of the terms must take well under a tenth of the time, quadratic growth would take 100x
+constexpr double MAX_SCALING = 30;
+
+constexpr int32_t X = 3, Y = 5;
+
+const char* const PHASES[] = {"parse", "analyze", "fold", "bytecode", "interp", "codegen", "native"};
+
+/**
+ * @brief Generated source with the value its main returns
+ */
+struct Case {
+    std::string source;
+    int32_t expected;
+};
+
+int32_t wrap(int64_t value) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+std::string program(const std::string& expression) {
+    return "fn f(x: int, y: int) {\n"
+           "    let a: int[4];\n"
+           "    a[0] = 1; a[1] = 2; a[2] = 3;\n"
+           "    return " + expression + ";\n"
+           "}\n"
+           "fn main() { return f(" + std::to_string(X) + ", " + std::to_string(Y) + "); }\n";
+}
+
+/**
+ * @brief Function to generate x * 3 + y - 7 + x * y / 2 - ..., a left-deep chain mixing precedences
+ */
+Case chain(size_t terms) {
+    std::string expression;
+    expression.reserve(terms * 8);
+    int64_t value = 0;
+    for (size_t i = 0; i < terms; ++i) {
+        bool subtract = i % 3 == 2;
+        if (i) expression += subtract ? " - " : " + ";
+        int32_t term;
+        switch (i % 4) {
+            case 0: expression += "x * 3"; term = X * 3; break;
+            case 1: expression += "y"; term = Y; break;
+            case 2: expression += "7"; term = 7; break;
+            default: expression += "x * y / 2"; term = X * Y / 2; break;
+        }
+        value = wrap(subtract ? value - term : value + term);
+    }
+    return {program(expression), static_cast<int32_t>(value)};
+}
+
+/**
+ * @brief Function to generate (x - (y - (x - ... (x)))), a right-deep chain of nested parentheses
+ */
+Case parentheses(size_t depth) {
+    std::string expression;
+    expression.reserve(depth * 7);
+    for (size_t i = 0; i < depth; ++i) {
+        expression += i % 2 ? "(y - " : "(x - ";
+    }
+    expression += "x";
+    expression.append(depth, ')');
+    int64_t value = X;
+    for (size_t i = depth; i-- > 0;) {
+        value = wrap((i % 2 ? Y : X) - value);
+    }
+    return {program(expression), static_cast<int32_t>(value)};
+}
+
+/**
+ * @brief Function to generate a[a[a[... a[0] ...]]], where a[i] holds (i + 1) % 4
+ */
+Case indexes(size_t depth) {
+    std::string expression;
+    expression.reserve(depth * 2 + 1);
+    for (size_t i = 0; i < depth; ++i) {
+        expression += "a[";
+    }
+    expression += "0";
+    expression.append(depth, ']');
+    return {program(expression), static_cast<int32_t>(depth % 4)};
+}
+
+/**
+ * @brief Function to generate if statements nested the given number of levels, an if and its block are two
+ */
+std::string nestedIfs(size_t levels) {
+    std::string body = "return 1;";
+    for (size_t i = 0; i < levels / 2; ++i) {
+        body = "if (x > " + std::to_string(i) + ") { " + body + " }";
+    }
+    return "fn main() {\n    let x: int = 1000000;\n    " + body + "\n    return 0;\n}\n";
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Timings {
+    double ms[std::size(PHASES)] = {};
+
+    double total() const {
+        double sum = 0;
+        for (double phase : ms) sum += phase;
+        return sum;
+    }
+};
+
+/**
+ * @brief Function to run a case through every phase up to codegen, all of which is released on return
+ * @return false if a phase failed or a result is wrong, after printing why
+ */
+bool runFrontPhases(const Case& test, Timings& timings) {
+    auto start = std::chrono::steady_clock::now();
+    Arena arena;
+    Lexer lexer(test.source);
+    DiagnosticEngine diagnostics("stress", test.source);
+    Parser parser(lexer, arena, diagnostics);
+    ASTNode* ast = parser.parse();
+    timings.ms[0] = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    SymbolTable symbolTable;
+    if (!diagnostics.hasErrors()) {
+        semanticAnalysis(ast, symbolTable, diagnostics);
+    }
+    timings.ms[1] = millisecondsSince(start);
+    if (diagnostics.hasErrors()) {
+        diagnostics.print(std::cerr);
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    foldConstants(ast, symbolTable);
+    timings.ms[2] = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    BytecodeProgram bytecode = compileBytecode(ast, symbolTable);
+    timings.ms[3] = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    Interpreter interpreter(bytecode, nullptr, 0);
+    int32_t interpreted = 0;
+    bool ran = interpreter.run(interpreted);
+    timings.ms[4] = millisecondsSince(start);
+    if (!ran || interpreted != test.expected) {
+        std::cerr << "Interpreter returned " << interpreted << ", expected " << test.expected << "\n";
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    CodeGenerator generator;
+    generator.generate(ast, symbolTable);
+    bool broken = llvm::verifyModule(generator.module(), &llvm::errs());
+    timings.ms[5] = millisecondsSince(start);
+    return !broken;
+}
+
+/**
+ * @brief Function to run a case through every phase, the native phase compiles the source on its own
+ *        once the AST, bytecode and module of the earlier phases are freed
+ * @return false if a phase failed or a result is wrong, after printing why
+ */
+bool runCase(const Case& test, Timings& timings) {
+    if (!runFrontPhases(test, timings)) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    nova::Compiler compiler;
+    nova::Program native = compiler.load(test.source);
+    int32_t result = 0;
+    bool called = false;
+    // the JIT compiles on this thread, the generated code runs on one with a default stack: at -O0
+    // every checked index spills to a stack slot of its own, 4 MB of frame at a million of them
+    std::thread([&] { called = native.runMain(result); }).join();
+    timings.ms[6] = millisecondsSince(start);
+    if (!called || result != test.expected) {
+        std::cerr << "Native code returned " << result << ", expected " << test.expected << "\n"
+                  << native.diagnostics().text;
+        return false;
+    }
+    return true;
+}
+
+void report(const char* shape, size_t terms, const Timings& timings) {
+    std::cout << std::left << std::setw(12) << shape << std::right << std::setw(9) << terms;
+    for (double ms : timings.ms) {
+        std::cout << std::fixed << std::setprecision(1) << std::setw(10) << ms;
+    }
+    std::cout << std::setw(10) << timings.total() * 1000 / terms << "\n";
+}
+
+bool checkNesting() {
+    nova::Compiler compiler;
+    // an if and its block each count towards the limit, main's body does not
+    if (!compiler.check(nestedIfs(MAX_NESTING_DEPTH)).empty()) {
+        std::cerr << "Statements nested " << MAX_NESTING_DEPTH << " deep were rejected\n";
+        return false;
+    }
+    nova::Program program = compiler.load(nestedIfs(MAX_NESTING_DEPTH));
+    int32_t result = 0;
+    if (!program.runMain(result) || result != 1) {
+        std::cerr << "Statements nested " << MAX_NESTING_DEPTH << " deep did not run\n" << program.diagnostics().text;
+        return false;
+    }
+    nova::Diagnostics tooDeep = compiler.check(nestedIfs(MAX_NESTING_DEPTH + 2));
+    if (tooDeep.errors.size() != 1 || tooDeep.errors[0].message.find("nested") == std::string::npos) {
+        std::cerr << "Statements nested too deeply were not reported\n" << tooDeep.text;
+        return false;
+    }
+    return true;
+}
+
+struct Run {
+    size_t terms;
+    bool ok = false;
+};
+
+void* runAll(void* argument) {
+    Run& run = *static_cast<Run*>(argument);
+    std::cout << std::left << std::setw(12) << "shape" << std::right << std::setw(9) << "terms";
+    for (const char* phase : PHASES) {
+        std::cout << std::setw(10) << phase;
+    }
+    std::cout << std::setw(10) << "us/term" << "   (ms per phase)\n";
+
+    const std::pair<const char*, std::function<Case(size_t)>> shapes[] = {
+        {"chain", chain}, {"parentheses", parentheses}, {"indexes", indexes}};
+    bool ok = true;
+    for (const auto& [shape, generate] : shapes) {
+        Timings small, large;
+        bool passed = runCase(generate(run.terms / 10), small) && runCase(generate(run.terms), large);
+        report(shape, run.terms / 10, small);
+        report(shape, run.terms, large);
+        if (!passed) {
+            std::cerr << shape << ": wrong result\n";
+            ok = false;
+        } else if (large.total() > small.total() * MAX_SCALING) {
+            std::cerr << shape << ": " << run.terms << " terms took " << large.total() / small.total()
+                      << " times as long as " << run.terms / 10 << "\n";
+            ok = false;
+        }
+    }
+    run.ok = ok && checkNesting();
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Run run{1000000};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--terms=", 0) == 0 && std::atoll(arg.c_str() + 8) >= 10) {
+            run.terms = static_cast<size_t>(std::atoll(arg.c_str() + 8));
+        } else {
+            std::cerr << "Usage: stress [--terms=N]\n";
+            return 1;
+        }
+    }
+    log::setLevel(LogLevel::NONE);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, STRESS_STACK_BYTES);
+    pthread_t thread;
+    if (pthread_create(&thread, &attributes, runAll, &run) != 0) {
+        std::cerr << "Could not start the stress thread\n";
+        return 1;
+    }
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attributes);
+
+    if (!run.ok) {
+        std::cerr << "FAILED\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,61 +1,344 @@
 #include "analysis.h"
+#include "../jit/runtime.h"
+#include <algorithm>
 
-void handleAnalysisError(const std::string& message) {
-    std::cerr << "Analysis Error: " << message << std::endl;
-    std::exit(1);
+void handleAnalysisError(const std::string& message, SourceSpan span) {
+    throw CompileError(message, span);
 }
 
-void SymbolTable::addSymbol(const std::string& name, const std::string& type) {
-    if (table.count(name)) {
-        handleAnalysisError("Symbol already defined: " + name);
+const char* valueTypeName(ValueType type) {
+    switch (type) {
+        case ValueType::Int: return "int";
+        case ValueType::IntArray: return "int[]";
     }
-    table[name] = {name, type};
+    return "unknown";
 }
 
-const Symbol& SymbolTable::getSymbol(const std::string& name) const {
-    if (!table.count(name)) {
-        handleAnalysisError("Symbol not found: " + name);
+void SymbolTable::enterScope() {
+    scopeMarks.push_back(active.size());
+}
+
+void SymbolTable::exitScope() {
+    size_t mark = scopeMarks.back();
+    scopeMarks.pop_back();
+    while (active.size() > mark) {
+        const Symbol& symbol = symbols[active.back()];
+        visible[symbol.name] = symbol.shadowed;
+        active.pop_back();
+    }
+}
+
+int32_t SymbolTable::addSymbol(std::string_view name, ValueType type, SymbolKind kind, SourceSpan span) {
+    uint32_t id = interner.intern(name);
+    if (id >= visible.size()) {
+        visible.resize(id + 1, -1);
+    }
+
+    uint32_t depth = static_cast<uint32_t>(scopeMarks.size());
+    int32_t previous = visible[id];
+    if (previous >= 0 && symbols[previous].depth == depth) {
+        handleAnalysisError("Symbol already defined: " + std::string(name), span);
+    }
+
+    int32_t slot = static_cast<int32_t>(symbols.size());
+    symbols.push_back({id, type, kind, depth, previous});
+    visible[id] = slot;
+    active.push_back(slot);
+    return slot;
+}
+
+void SymbolTable::setParameterLengths(int32_t function, const std::vector<uint32_t>& lengths) {
+    symbols[function].parameters = static_cast<uint32_t>(parameterLengths.size());
+    parameterLengths.insert(parameterLengths.end(), lengths.begin(), lengths.end());
+}
+
+int32_t SymbolTable::restoreSymbol(std::string_view name, Symbol symbol) {
+    symbol.name = interner.intern(name);
+    symbols.push_back(symbol);
+    return static_cast<int32_t>(symbols.size() - 1);
+}
+
+int32_t SymbolTable::resolve(std::string_view name, SourceSpan span) const {
+    uint32_t id = interner.find(name);
+    if (id == StringInterner::NOT_FOUND || visible[id] < 0) {
+        handleAnalysisError("Symbol not found: " + std::string(name), span);
+    }
+    return visible[id];
+}
+
+/**
+ * @brief Function to resolve an array passed to a call
+ * @param call Call node, resolved
+ * @param i Index of the argument, a parameter declared as an array
+ */
+static void analyzeArrayArgument(ASTNode* call, uint32_t i, SymbolTable& symbolTable) {
+    ASTNode* argument = call->children[i];
+    uint32_t length = symbolTable.parameterLength(call->symbol, i);
+    std::string expected = "Argument " + std::to_string(i + 1) + " of " + std::string(call->value) +
+                           " must be an int[" + std::to_string(length) + "] array";
+    if (argument->kind != NodeKind::Variable) {
+        handleAnalysisError(expected, argument->span());
+    }
+    argument->symbol = symbolTable.resolve(argument->value, argument->span());
+    const Symbol& array = symbolTable.getSymbol(argument->symbol);
+    if (array.type != ValueType::IntArray || array.length != length) {
+        handleAnalysisError(expected, argument->span());
+    }
+    // arrays are passed by reference and must not alias, so the callee may assume they don't
+    for (uint32_t j = 0; j < i; ++j) {
+        if (symbolTable.parameterLength(call->symbol, j) != 0 && call->children[j]->symbol == argument->symbol) {
+            handleAnalysisError("Array " + std::string(argument->value) + " is passed to " +
+                                std::string(call->value) + " more than once", argument->span());
+        }
+    }
+}
+
+/**
+ * @brief Function to resolve a node of an expression before its children are analyzed
+ * @return Whether the node has children to analyze
+ */
+static bool enterExpression(ASTNode* ast, SymbolTable& symbolTable) {
+    switch (ast->kind) {
+    case NodeKind::Literal:
+        return false;
+    case NodeKind::Variable: {
+        ast->symbol = symbolTable.resolve(ast->value, ast->span());
+        const Symbol& symbol = symbolTable.getSymbol(ast->symbol);
+        if (symbol.kind == SymbolKind::Function) {
+            handleAnalysisError("Function used as a value: " + std::string(ast->value), ast->span());
+        }
+        if (symbol.type == ValueType::IntArray) {
+            handleAnalysisError("Array used as a value: " + std::string(ast->value), ast->span());
+        }
+        return false;
+    }
+    case NodeKind::Index: {
+        ast->symbol = symbolTable.resolve(ast->value, ast->span());
+        const Symbol& array = symbolTable.getSymbol(ast->symbol);
+        if (array.type != ValueType::IntArray) {
+            handleAnalysisError("Indexed variable is not an array: " + std::string(ast->value), ast->span());
+        }
+        return true;
+    }
+    case NodeKind::Call: {
+        ast->symbol = symbolTable.resolve(ast->value, ast->span());
+        const Symbol& callee = symbolTable.getSymbol(ast->symbol);
+        if (callee.kind != SymbolKind::Function) {
+            handleAnalysisError("Called object is not a function: " + std::string(ast->value), ast->span());
+        }
+        if (callee.arity != ast->children.size()) {
+            handleAnalysisError("Function " + std::string(ast->value) + " expects " + std::to_string(callee.arity) +
+                                " arguments, got " + std::to_string(ast->children.size()), ast->span());
+        }
+        return !ast->children.empty();
+    }
+    case NodeKind::BinaryOp:
+        return true;
+    default:
+        handleAnalysisError(std::string("Unexpected node in expression: ") + nodeKindName(ast->kind), ast->span());
+        return false;
     }
-    return table.at(name);
 }
 
-void semanticAnalysis(ASTNode* ast, SymbolTable& symbolTable) {
-    if (ast->type == "Function") {
+/**
+ * @brief Function to resolve the variables of an expression. Walks the expression with an
+ *        explicit stack, so expressions of any depth are safe to analyze.
+ * @return Type of the expression
+ */
+static ValueType analyzeExpression(ASTNode* ast, SymbolTable& symbolTable) {
+    // node, next child to analyze; kept across calls so only the first expression allocates
+    thread_local std::vector<std::pair<ASTNode*, uint32_t>> stack;
+    stack.clear(); // an error thrown mid-walk leaves nodes behind
+    if (enterExpression(ast, symbolTable)) {
+        stack.emplace_back(ast, 0);
+    }
+    while (!stack.empty()) {
+        auto& [node, next] = stack.back();
+        if (next < node->children.size()) {
+            uint32_t i = next++;
+            ASTNode* parent = node;
+            if (parent->kind == NodeKind::Call && symbolTable.parameterLength(parent->symbol, i) != 0) {
+                analyzeArrayArgument(parent, i, symbolTable);
+            } else if (enterExpression(parent->children[i], symbolTable)) {
+                stack.emplace_back(parent->children[i], 0);
+            }
+            continue;
+        }
+        if (node->kind == NodeKind::Index) {
+            const ASTNode* index = node->children[0];
+            uint32_t length = symbolTable.getSymbol(node->symbol).length;
+            if (index->kind == NodeKind::Literal && (index->number < 0 || static_cast<uint32_t>(index->number) >= length)) {
+                handleAnalysisError("Index " + std::to_string(index->number) + " is out of bounds for int[" +
+                                    std::to_string(length) + "]", index->span());
+            }
+        }
+        stack.pop_back();
+    }
+    // variables are checked to hold an int, calls return their function's type
+    bool typed = ast->kind == NodeKind::Variable || ast->kind == NodeKind::Call;
+    return typed ? symbolTable.getSymbol(ast->symbol).type : ValueType::Int;
+}
+
+static ValueType parseTypeName(const ASTNode* typeNode) {
+    if (typeNode->value != valueTypeName(ValueType::Int)) {
+        handleAnalysisError("Unknown type: " + std::string(typeNode->value), typeNode->span());
+    }
+    return typeNode->number > 0 ? ValueType::IntArray : ValueType::Int;
+}
+
+/**
+ * @brief Scope opened for the lifetime of the guard, closed on errors as well
+ */
+struct ScopeGuard {
+    SymbolTable& symbolTable;
+    explicit ScopeGuard(SymbolTable& symbolTable) : symbolTable(symbolTable) { symbolTable.enterScope(); }
+    ~ScopeGuard() { symbolTable.exitScope(); }
+};
+
+/**
+ * @brief Function to analyze statements one at a time, an error is reported and analysis goes on with the next one
+ */
+static void analyzeStatements(NodeList statements, SymbolTable& symbolTable, DiagnosticEngine& diagnostics) {
+    for (auto* statement : statements) {
+        try {
+            semanticAnalysis(statement, symbolTable, diagnostics);
+        } catch (const CompileError& error) {
+            diagnostics.recover(error);
+        }
+    }
+}
+
+void declareFunctions(ASTNode* program, SymbolTable& symbolTable, DiagnosticEngine& diagnostics) {
+    std::vector<uint32_t> lengths;
+    for (auto* function : program->children) {
+        uint32_t arity = 0;
+        lengths.clear();
+        while (arity < function->children.size() && function->children[arity]->kind == NodeKind::Parameter) {
+            lengths.push_back(static_cast<uint32_t>(function->children[arity]->children[0]->number));
+            ++arity;
+        }
+        try {
+            if (isRuntimeName(function->value)) {
+                handleAnalysisError("Function name " + std::string(function->value) + " is reserved by the runtime",
+                                    function->span());
+            }
+            function->symbol = symbolTable.addSymbol(function->value, ValueType::Int, SymbolKind::Function,
+                                                     function->span());
+            symbolTable.getSymbol(function->symbol).arity = arity;
+            symbolTable.setParameterLengths(function->symbol, lengths);
+            if (function->value == "main" && arity != 0) {
+                handleAnalysisError("main must not take parameters", function->span());
+            }
+        } catch (const CompileError& error) {
+            diagnostics.recover(error);
+        }
+    }
+}
+
+void semanticAnalysis(ASTNode* ast, SymbolTable& symbolTable, DiagnosticEngine& diagnostics) {
+    switch (ast->kind) {
+    case NodeKind::Program:
+        // declare every function first so calls may refer to later ones
+        declareFunctions(ast, symbolTable, diagnostics);
+        for (auto* function : ast->children) {
+            // a redefinition has no slot, its body is not analyzed
+            if (function->symbol >= 0) {
+                semanticAnalysis(function, symbolTable, diagnostics);
+            }
+        }
+        break;
+    case NodeKind::Function: {
         // Analyze function body
-        for (auto* child : ast->children) {
-            semanticAnalysis(child, symbolTable);
-        }
-    } else if (ast->type == "VariableDeclaration") {
-        std::string varName = ast->value;
-        std::string inferredType;
-
-        // Check if type is explicitly declared
-        if (ast->children[0]->type == "Type") {
-            inferredType = ast->children[0]->value;
-        } else {
-            // Infer type from the assigned value
-            ASTNode* valueNode = ast->children[0];
-            if (valueNode->type == "Literal") {
-                if (std::all_of(valueNode->value.begin(), valueNode->value.end(), ::isdigit)) {
-                    inferredType = "int";
-                } else {
-                    handleAnalysisError("Unable to infer type for: " + varName);
-                }
-            } else if (valueNode->type == "Variable") {
-                Symbol symbol = symbolTable.getSymbol(valueNode->value);
-                inferredType = symbol.type;
-            } else {
-                handleAnalysisError("Unable to infer type for: " + varName);
+        int32_t firstLocal = static_cast<int32_t>(symbolTable.size());
+        {
+            ScopeGuard scope(symbolTable);
+            analyzeStatements(ast->children, symbolTable, diagnostics);
+        }
+        Symbol& function = symbolTable.getSymbol(ast->symbol);
+        function.firstLocal = firstLocal;
+        function.localCount = static_cast<uint32_t>(symbolTable.size()) - firstLocal;
+        break;
+    }
+    case NodeKind::Parameter: {
+        ValueType type = ValueType::Int;
+        try {
+            type = parseTypeName(ast->children[0]);
+        } catch (const CompileError& error) {
+            // still declared, so its uses are not reported as well
+            diagnostics.recover(error);
+        }
+        ast->symbol = symbolTable.addSymbol(ast->value, type, SymbolKind::Parameter, ast->span());
+        symbolTable.getSymbol(ast->symbol).length = static_cast<uint32_t>(ast->children[0]->number);
+        break;
+    }
+    case NodeKind::VariableDeclaration: {
+        std::string_view varName = ast->value;
+
+        // an array is declared without an initializer
+        ASTNode* typeNode = ast->children[0]->kind == NodeKind::Type ? ast->children[0] : nullptr;
+        ASTNode* initializer = ast->children[ast->children.size() - 1];
+        if (initializer == typeNode) initializer = nullptr;
+
+        // the initializer is resolved before the name is declared, so it cannot refer to itself
+        ValueType inferredType = typeNode && typeNode->number > 0 ? ValueType::IntArray : ValueType::Int;
+        try {
+            if (initializer) {
+                inferredType = analyzeExpression(initializer, symbolTable);
             }
+
+            // Check if type is explicitly declared
+            if (typeNode) {
+                inferredType = parseTypeName(typeNode);
+            }
+        } catch (const CompileError& error) {
+            // still declared, so its uses are not reported as well
+            diagnostics.recover(error);
         }
 
         // Add the variable to the symbol table
-        symbolTable.addSymbol(varName, inferredType);
-        log::debug("Added variable: " + varName + " with type: " + inferredType);
-    } else if (ast->type == "ReturnStatement") {
-        if (ast->children.empty() || 
-            (ast->children[0]->type != "Literal" && ast->children[0]->type != "Variable")) {
-            handleAnalysisError("Invalid return statement");
+        ast->symbol = symbolTable.addSymbol(varName, inferredType, SymbolKind::Variable, ast->span());
+        if (typeNode) {
+            symbolTable.getSymbol(ast->symbol).length = static_cast<uint32_t>(typeNode->number);
+        }
+        log::debug("Added variable: {} with type: {}", varName, valueTypeName(inferredType));
+        break;
+    }
+    case NodeKind::ReturnStatement:
+        if (ast->children.empty()) {
+            handleAnalysisError("Invalid return statement", ast->span());
         }
+        analyzeExpression(ast->children[0], symbolTable);
+        break;
+    case NodeKind::Assignment:
+        // a Variable target is checked like a read, which rejects functions and whole arrays
+        analyzeExpression(ast->children[0], symbolTable);
+        analyzeExpression(ast->children[1], symbolTable);
+        break;
+    case NodeKind::Call:
+        analyzeExpression(ast, symbolTable);
+        break;
+    case NodeKind::Block: {
+        ScopeGuard scope(symbolTable);
+        analyzeStatements(ast->children, symbolTable, diagnostics);
+        break;
     }
-}
\ No newline at end of file
+    case NodeKind::If:
+    case NodeKind::While:
+        analyzeExpression(ast->children[0], symbolTable);
+        for (size_t i = 1; i < ast->children.size(); ++i) {
+            semanticAnalysis(ast->children[i], symbolTable, diagnostics);
+        }
+        break;
+    case NodeKind::For: {
+        // the loop variable is scoped to the loop
+        ScopeGuard scope(symbolTable);
+        semanticAnalysis(ast->children[0], symbolTable, diagnostics);
+        analyzeExpression(ast->children[1], symbolTable);
+        semanticAnalysis(ast->children[2], symbolTable, diagnostics);
+        semanticAnalysis(ast->children[3], symbolTable, diagnostics);
+        break;
+    }
+    default:
+        break;
+    }
+}
@@ -1,47 +1,165 @@
 #ifndef ANALYSIS_H
 #define ANALYSIS_H
-#include <unordered_map>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <algorithm>
 #include <stdexcept>
 #include "../parser/parser.h"
 #include "../tokenizer/tokenize.h"
+#include "interner.h"
+
+enum class ValueType : uint8_t {
+    Int,
+    IntArray  // fixed length int[N], passed by reference
+};
+
+/**
+ * @brief Function to get the source spelling of a type
+ */
+const char* valueTypeName(ValueType type);
+
+enum class SymbolKind : uint8_t {
+    Variable,
+    Parameter,
+    Function
+};
 
 struct Symbol {
-    std::string name;
-    std::string type; // E.g., "int", "void"
+    uint32_t name;       // interned name ID
+    ValueType type;      // variable type, or return type of a function
+    SymbolKind kind;
+    uint32_t depth;      // scope nesting level of the declaration
+    int32_t shadowed;    // slot this declaration hides, -1 if none
+    uint32_t length = 0; // arrays only: number of elements
+    // functions only: parameter count and the contiguous slot range of their parameters and locals
+    uint32_t arity = 0;
+    int32_t firstLocal = 0;
+    uint32_t localCount = 0;
+    uint32_t parameters = 0; // offset of the parameters' array lengths in SymbolTable's pool
 };
+
 /**
  * @brief Function to handle analysis error
+ * @param message Error message
+ * @param span Source range the error points at
+ * @throws CompileError
  */
-void handleAnalysisError(const std::string& message);
+void handleAnalysisError(const std::string& message, SourceSpan span = {});
 
+/**
+ * @brief Flat symbol table with nested scopes. Every declaration gets a dense slot,
+ *        the innermost visible declaration of each name ID is found with one array
+ *        index and hidden declarations are chained through Symbol::shadowed.
+ *        Slots stay valid after their scope closes, codegen indexes its values by them.
+ */
 class SymbolTable {
 private:
-    std::unordered_map<std::string, Symbol> table;
+    StringInterner interner;
+    std::vector<Symbol> symbols;   // indexed by slot
+    std::vector<int32_t> visible;  // indexed by name ID, innermost visible slot or -1
+    std::vector<int32_t> active;   // slots declared in the open scopes, in order
+    std::vector<size_t> scopeMarks; // size of active when each open scope was entered
+    std::vector<uint32_t> parameterLengths; // per function, array length of each parameter, 0 for an int
 
 public:
     /**
-     * @brief Function to add symbol to the symbol table
-     * @param name Name of the symbol
+     * @brief Function to open a nested scope
+     */
+    void enterScope();
+
+    /**
+     * @brief Function to close the innermost scope, its declarations stop being visible
+     */
+    void exitScope();
+
+    /**
+     * @brief Function to declare a symbol in the innermost scope
+     * @param name Name of the symbol, must outlive the table
      * @param type Type of the symbol
+     * @param kind What the name denotes
+     * @param span Source range of the declaration, reported with errors
+     * @return Slot of the new symbol
+     * @throws CompileError if the name is already declared in the same scope
      */
-    void addSymbol(const std::string& name, const std::string& type);
+    int32_t addSymbol(std::string_view name, ValueType type, SymbolKind kind = SymbolKind::Variable,
+                      SourceSpan span = {});
 
     /**
-     * @brief Function to get symbol from the symbol table
+     * @brief Function to resolve a name to its innermost visible declaration
      * @param name Name of the symbol
-     * @return Symbol
+     * @param span Source range of the reference, reported with errors
+     * @return Slot
+     * @throws CompileError if no declaration is visible
+     */
+    int32_t resolve(std::string_view name, SourceSpan span = {}) const;
+
+    /**
+     * @brief Function to get a symbol by slot
+     */
+    const Symbol& getSymbol(int32_t slot) const { return symbols[slot]; }
+
+    /**
+     * @brief Function to get a symbol by slot for updating, e.g. a function's arity and locals
+     */
+    Symbol& getSymbol(int32_t slot) { return symbols[slot]; }
+
+    /**
+     * @brief Function to record the signature of a function, so calls can be checked
+     *        and generated before or without analyzing its body
+     * @param function Slot of the function, its arity must be set
+     * @param lengths Array length of each parameter, 0 for an int
+     */
+    void setParameterLengths(int32_t function, const std::vector<uint32_t>& lengths);
+
+    /**
+     * @brief Function to append a symbol saved from another table, without declaring it in a scope
+     * @param name Name of the symbol, must outlive the table
+     * @param symbol Symbol, its name ID is replaced and functions need setParameterLengths afterwards
+     * @return Slot of the symbol
+     */
+    int32_t restoreSymbol(std::string_view name, Symbol symbol);
+
+    /**
+     * @brief Function to get the array length of a function's parameter
+     * @param function Slot of the function
+     * @param index Parameter index, below the arity
+     * @return Length, 0 if the parameter is an int
      */
-    const Symbol& getSymbol(const std::string& name) const;
+    uint32_t parameterLength(int32_t function, uint32_t index) const {
+        return parameterLengths[symbols[function].parameters + index];
+    }
+
+    /**
+     * @brief Function to get the name of a symbol
+     */
+    std::string_view nameOf(int32_t slot) const { return interner.name(symbols[slot].name); }
+
+    /**
+     * @brief Function to get the number of slots handed out so far
+     */
+    size_t size() const { return symbols.size(); }
 };
 
 /**
- * @brief Function to perform semantic analysis
- * @param ast AST node
+ * @brief Function to declare every function of a program in the outermost scope, without analyzing the bodies
+ * @param program Program node
+ * @param symbolTable Symbol table
+ * @param diagnostics Collects redefinitions and invalid signatures
+ * @throws ErrorLimitReached once the diagnostics hold their maximum number of errors
+ */
+void declareFunctions(ASTNode* program, SymbolTable& symbolTable, DiagnosticEngine& diagnostics);
+
+/**
+ * @brief Function to perform semantic analysis. Resolves every variable
+ *        reference and call and stores the symbol slot in ASTNode::symbol.
+ *        Functions may call functions declared later in the program.
+ *        Errors are reported per statement and analysis continues with the next one.
+ * @param ast Program node, or a Function node once declareFunctions has run
  * @param symbolTable Symbol table
+ * @param diagnostics Collects the errors
+ * @throws ErrorLimitReached once the diagnostics hold their maximum number of errors
  */
-void semanticAnalysis(ASTNode* ast, SymbolTable& symbolTable);
+void semanticAnalysis(ASTNode* ast, SymbolTable& symbolTable, DiagnosticEngine& diagnostics);
 
-#endif // ANALYSIS_H
\ No newline at end of file
+#endif // ANALYSIS_H
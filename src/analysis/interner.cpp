@@ -0,0 +1,59 @@
+#include "interner.h"
+
+uint64_t StringInterner::hash(std::string_view text) {
+    // FNV-1a, identifiers are short
+    uint64_t value = 14695981039346656037ull;
+    for (char c : text) {
+        value ^= static_cast<unsigned char>(c);
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+uint32_t StringInterner::intern(std::string_view text) {
+    uint64_t h = hash(text);
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        uint32_t id = slots[i];
+        if (id == EMPTY) {
+            id = static_cast<uint32_t>(names.size());
+            names.push_back(text);
+            hashes.push_back(h);
+            slots[i] = id;
+            if (names.size() * 2 > slots.size()) {
+                grow();
+            }
+            return id;
+        }
+        if (hashes[id] == h && names[id] == text) {
+            return id;
+        }
+    }
+}
+
+uint32_t StringInterner::find(std::string_view text) const {
+    uint64_t h = hash(text);
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        uint32_t id = slots[i];
+        if (id == EMPTY) {
+            return NOT_FOUND;
+        }
+        if (hashes[id] == h && names[id] == text) {
+            return id;
+        }
+    }
+}
+
+void StringInterner::grow() {
+    std::vector<uint32_t> larger(slots.size() * 2, EMPTY);
+    size_t mask = larger.size() - 1;
+    for (uint32_t id = 0; id < names.size(); ++id) {
+        size_t i = hashes[id] & mask;
+        while (larger[i] != EMPTY) {
+            i = (i + 1) & mask;
+        }
+        larger[i] = id;
+    }
+    slots.swap(larger);
+}
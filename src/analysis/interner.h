@@ -0,0 +1,54 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Maps identifier text to dense integer IDs, so names are hashed once
+ *        and compared as integers afterwards. Open addressing over a flat array.
+ *        The interned text is not copied, it must outlive the interner
+ *        (identifiers view into the SourceBuffer).
+ */
+class StringInterner {
+public:
+    StringInterner() : slots(64, EMPTY) {}
+
+    /**
+     * @brief Function to get the ID of a name, assigning the next free one on first sight
+     * @param text Name to intern
+     * @return ID, dense from 0
+     */
+    uint32_t intern(std::string_view text);
+
+    /**
+     * @brief Function to get the ID of a name without interning it
+     * @return ID, or NOT_FOUND if the name was never interned
+     */
+    uint32_t find(std::string_view text) const;
+
+    /**
+     * @brief Function to get the text of an ID
+     */
+    std::string_view name(uint32_t id) const { return names[id]; }
+
+    /**
+     * @brief Function to get the number of distinct names
+     */
+    size_t size() const { return names.size(); }
+
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    static uint64_t hash(std::string_view text);
+    void grow();
+
+    std::vector<uint32_t> slots; // IDs, EMPTY for unused slots; size is a power of two
+    std::vector<std::string_view> names;
+    std::vector<uint64_t> hashes; // per ID, so growing does not rehash the text
+};
+
+#endif // INTERNER_H
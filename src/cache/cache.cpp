@@ -0,0 +1,118 @@
+#include "cache.h"
+#include "../logger/logger.h"
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA256.h>
+#include <algorithm>
+#include <utime.h>
+#include <vector>
+
+CompilationCache::CompilationCache(std::string directory, uint64_t maxBytes)
+    : directory(std::move(directory)), maxBytes(maxBytes) {}
+
+std::string CompilationCache::key(std::string_view source, std::string_view configuration) {
+    llvm::SHA256 hasher;
+    hasher.update(llvm::StringRef(configuration.data(), configuration.size()));
+    hasher.update(llvm::StringRef("\0", 1)); // keep configuration and source from running together
+    hasher.update(llvm::StringRef(source.data(), source.size()));
+    return llvm::toHex(hasher.final(), true);
+}
+
+std::string CompilationCache::entryPath(const std::string& key) const {
+    llvm::SmallString<256> path(directory);
+    llvm::sys::path::append(path, key);
+    return path.str().str();
+}
+
+bool CompilationCache::fetch(const std::string& key, const std::string& output) {
+    std::string entry = entryPath(key);
+    if (!llvm::sys::fs::exists(entry) || llvm::sys::fs::copy_file(entry, output)) {
+        ++missCount;
+        return false;
+    }
+
+    // refresh the modification time, eviction treats it as the last use
+    ::utime(entry.c_str(), nullptr);
+    // copy_file does not preserve permissions, executables must stay runnable
+    if (auto permissions = llvm::sys::fs::getPermissions(entry)) {
+        llvm::sys::fs::setPermissions(output, *permissions);
+    }
+    ++hitCount;
+    log::debug("Cache hit for {}", output);
+    return true;
+}
+
+void CompilationCache::store(const std::string& key, const std::string& output) {
+    if (auto EC = llvm::sys::fs::create_directories(directory)) {
+        log::warn("Could not create cache directory {}: {}", directory, EC.message());
+        return;
+    }
+
+    // copy to a unique temporary first so concurrent readers never see a partial entry
+    std::string entry = entryPath(key);
+    llvm::SmallString<256> temporary;
+    int fd;
+    if (llvm::sys::fs::createUniqueFile(entry + ".tmp-%%%%%%", fd, temporary)) {
+        return;
+    }
+    llvm::sys::fs::closeFile(fd);
+    if (llvm::sys::fs::copy_file(output, temporary)) {
+        llvm::sys::fs::remove(temporary);
+        return;
+    }
+    if (auto permissions = llvm::sys::fs::getPermissions(output)) {
+        llvm::sys::fs::setPermissions(temporary, *permissions);
+    }
+    if (llvm::sys::fs::rename(temporary, entry)) {
+        llvm::sys::fs::remove(temporary);
+        return;
+    }
+
+    uint64_t size = 0;
+    llvm::sys::fs::file_size(entry, size);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentBytes += size;
+    }
+    evictIfNeeded();
+}
+
+void CompilationCache::evictIfNeeded() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (scanned && currentBytes <= maxBytes) {
+        return;
+    }
+
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        llvm::sys::TimePoint<> lastUse;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+
+    std::error_code EC;
+    for (llvm::sys::fs::directory_iterator it(directory, EC), end; it != end && !EC; it.increment(EC)) {
+        llvm::sys::fs::file_status status;
+        if (llvm::sys::fs::status(it->path(), status) || status.type() != llvm::sys::fs::file_type::regular_file) {
+            continue;
+        }
+        entries.push_back({it->path(), status.getSize(), status.getLastModificationTime()});
+        total += status.getSize();
+    }
+    scanned = true;
+    currentBytes = total;
+    if (currentBytes <= maxBytes) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+    for (const Entry& entry : entries) {
+        if (currentBytes <= maxBytes) break;
+        if (!llvm::sys::fs::remove(entry.path)) {
+            currentBytes -= entry.size;
+            ++evictionCount;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief On-disk, content-addressed store of compiler outputs. Entries are
+ *        named by a hash of everything that influences the output and are
+ *        evicted least-recently-used first once the directory exceeds its budget.
+ */
+class CompilationCache {
+public:
+    /**
+     * @param directory Cache directory, created on first use
+     * @param maxBytes Size budget for all entries
+     */
+    CompilationCache(std::string directory, uint64_t maxBytes);
+
+    /**
+     * @brief Function to compute the cache key for a compile
+     * @param source Source bytes
+     * @param configuration Every other input that changes the output (version, flags, target)
+     * @return Hex digest
+     */
+    static std::string key(std::string_view source, std::string_view configuration);
+
+    /**
+     * @brief Function to copy a cached output to its destination
+     * @param key Cache key
+     * @param output Destination path
+     * @return true on a hit
+     */
+    bool fetch(const std::string& key, const std::string& output);
+
+    /**
+     * @brief Function to add a freshly produced output to the cache
+     * @param key Cache key
+     * @param output Path of the produced file
+     */
+    void store(const std::string& key, const std::string& output);
+
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+    uint64_t evictions() const { return evictionCount; }
+
+private:
+    std::string entryPath(const std::string& key) const;
+    void evictIfNeeded();
+
+    std::string directory;
+    uint64_t maxBytes;
+    std::atomic<uint64_t> hitCount{0};
+    std::atomic<uint64_t> missCount{0};
+    std::atomic<uint64_t> evictionCount{0};
+
+    std::mutex mutex;       // guards the size accounting and eviction
+    bool scanned = false;   // currentBytes is computed from the directory once
+    uint64_t currentBytes = 0;
+};
+
+#endif // CACHE_H
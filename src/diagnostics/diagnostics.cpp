@@ -0,0 +1,71 @@
+#include "diagnostics.h"
+#include <algorithm>
+
+void DiagnosticEngine::error(SourceSpan span, std::string message) {
+    if (limitReached()) {
+        truncated = true;
+        return;
+    }
+    diagnostics.push_back({span, std::move(message)});
+}
+
+void DiagnosticEngine::recover(const CompileError& error) {
+    report(error);
+    if (limitReached()) {
+        truncated = true;
+        throw ErrorLimitReached();
+    }
+}
+
+SourceLocation DiagnosticEngine::locate(uint32_t offset) const {
+    if (offset > source.size()) {
+        return {};
+    }
+    if (lineStarts.empty()) {
+        lineStarts.push_back(0);
+        for (uint32_t i = 0; i < source.size(); ++i) {
+            if (source[i] == '\n') lineStarts.push_back(i + 1);
+        }
+    }
+    auto line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - 1;
+    return {static_cast<uint32_t>(line - lineStarts.begin()) + 1, offset - *line + 1};
+}
+
+void DiagnosticEngine::print(std::ostream& out) const {
+    // analysis declares every function before it checks the bodies, print in source order instead
+    std::vector<const Diagnostic*> ordered;
+    ordered.reserve(diagnostics.size());
+    for (const Diagnostic& diagnostic : diagnostics) ordered.push_back(&diagnostic);
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const Diagnostic* a, const Diagnostic* b) { return a->span.offset < b->span.offset; });
+
+    for (const Diagnostic* entry : ordered) {
+        const Diagnostic& diagnostic = *entry;
+        SourceLocation location = diagnostic.span.valid() ? locate(diagnostic.span.offset) : SourceLocation{};
+        if (location.line == 0) {
+            out << fileName << ": error: " << diagnostic.message << "\n";
+            continue;
+        }
+        out << fileName << ":" << location.line << ":" << location.column << ": error: " << diagnostic.message << "\n";
+
+        uint32_t lineStart = lineStarts[location.line - 1];
+        size_t lineEnd = source.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = source.size();
+        std::string_view text = source.substr(lineStart, lineEnd - lineStart);
+        out << "    " << text << "\n    ";
+        // tabs are kept so the caret lines up with the text above
+        for (uint32_t i = 0; i + 1 < location.column; ++i) {
+            out << (text[i] == '\t' ? '\t' : ' ');
+        }
+        out << '^';
+        size_t underline = std::min<size_t>(diagnostic.span.length, text.size() - (location.column - 1));
+        for (size_t i = 1; i < underline; ++i) out << '~';
+        out << "\n";
+    }
+    if (truncated) {
+        out << fileName << ": error: too many errors emitted, stopping now\n";
+    }
+    if (!diagnostics.empty()) {
+        out << diagnostics.size() << (diagnostics.size() == 1 ? " error" : " errors") << " generated.\n";
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Byte range of the source a diagnostic points at
+ */
+struct SourceSpan {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t offset = NONE; // NONE for errors without a position, e.g. from the code generator
+    uint32_t length = 0;
+
+    bool valid() const { return offset != NONE; }
+};
+
+/**
+ * @brief Line and column of a source offset, both 1-based
+ */
+struct SourceLocation {
+    uint32_t line = 0;
+    uint32_t column = 0;
+};
+
+/**
+ * @brief Error raised by the front end and code generator, aborts the construct being compiled.
+ *        The parser and semantic analysis recover from it, later phases abort the compile.
+ */
+struct CompileError : std::runtime_error {
+    explicit CompileError(const std::string& message, SourceSpan span = {})
+        : std::runtime_error(message), span(span) {}
+
+    SourceSpan span;
+};
+
+/**
+ * @brief Raised once the error limit of a DiagnosticEngine is reached, unwinds past every recovery point
+ */
+struct ErrorLimitReached : std::runtime_error {
+    ErrorLimitReached() : std::runtime_error("too many errors emitted, stopping now") {}
+};
+
+struct Diagnostic {
+    SourceSpan span;
+    std::string message;
+};
+
+/**
+ * @brief Collects the errors of one compile so they can be reported together
+ */
+class DiagnosticEngine {
+public:
+    /**
+     * @param fileName Name printed in front of every diagnostic
+     * @param source Source text the spans point into, must outlive the engine
+     * @param maxErrors Errors collected before recover() stops the compile, 0 for no limit
+     */
+    DiagnosticEngine(std::string fileName, std::string_view source, size_t maxErrors = 20)
+        : fileName(std::move(fileName)), source(source), maxErrors(maxErrors) {}
+
+    /**
+     * @brief Function to record an error, dropped once the limit is reached
+     * @param span Source range of the error
+     * @param message Error message
+     */
+    void error(SourceSpan span, std::string message);
+    /**
+     * @brief Function to record a CompileError
+     * @param error Caught error
+     */
+    void report(const CompileError& error) { this->error(error.span, error.what()); }
+    /**
+     * @brief Function to record an error the caller is about to recover from
+     * @param error Caught error
+     * @throws ErrorLimitReached if the error limit is reached
+     */
+    void recover(const CompileError& error);
+
+    bool hasErrors() const { return !diagnostics.empty(); }
+    size_t errorCount() const { return diagnostics.size(); }
+    bool limitReached() const { return maxErrors && diagnostics.size() >= maxErrors; }
+    const std::vector<Diagnostic>& all() const { return diagnostics; }
+
+    /**
+     * @brief Function to get the line and column of a source offset
+     * @param offset Byte offset into the source
+     * @return Location, line 0 if the offset lies outside the source
+     */
+    SourceLocation locate(uint32_t offset) const;
+
+    /**
+     * @brief Function to print every diagnostic as file:line:column: error: message,
+     *        followed by the source line and a caret under the span, and a summary line
+     * @param out Stream to print to
+     */
+    void print(std::ostream& out) const;
+
+private:
+    std::string fileName;
+    std::string_view source;
+    size_t maxErrors;
+    std::vector<Diagnostic> diagnostics;
+    bool truncated = false;
+    // offsets at which each line starts, built on the first locate()
+    mutable std::vector<uint32_t> lineStarts;
+};
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,406 @@
+#include "driver.h"
+#include "thread_pool.h"
+#include "parallel_codegen.h"
+#include "incremental.h"
+#include "version.h"
+#include "../logger/logger.h"
+#include "../source/source_buffer.h"
+#include "../tokenizer/tokenize.h"
+#include "../parser/parser.h"
+#include "../diagnostics/diagnostics.h"
+#include "../analysis/analysis.h"
+#include "../llvm/llvm_generator.h"
+#include "../jit/jit.h"
+#include "../interp/bytecode.h"
+#include "../interp/interpreter.h"
+#include "../optimizer/optimizer.h"
+#include "../optimizer/fold.h"
+#include "../target/target.h"
+#include "../emit/emit.h"
+#include "../serialize/ast_file.h"
+#include "../timing/time_report.h"
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+/**
+ * @brief Function to get the threads a file's functions are generated on. Partitions are only
+ *        generated and cleaned up apart, the output does not depend on the thread count.
+ */
+static unsigned codegenThreadsFor(const Options& options) {
+    return options.codegenThreads ? options.codegenThreads : std::thread::hardware_concurrency();
+}
+
+static std::string cacheConfiguration(const Options& options) {
+    return std::string(NOVA_VERSION) + ";O" + std::to_string(static_cast<int>(options.optLevel)) + ";emit" +
+           std::to_string(static_cast<int>(options.emit)) + ";" + hostTargetDescription();
+}
+
+static std::string incrementalConfiguration(const Options& options) {
+    // the stored bitcode is optimized but not lowered, the emit kind does not matter
+    return std::string(NOVA_VERSION) + ";O" + std::to_string(static_cast<int>(options.optLevel)) + ";" +
+           hostTargetDescription();
+}
+
+static void printDiagnostics(const DiagnosticEngine& diagnostics) {
+    // formatted up front so the diagnostics of concurrent jobs do not interleave
+    std::ostringstream out;
+    diagnostics.print(out);
+    static std::mutex printMutex;
+    std::lock_guard<std::mutex> lock(printMutex);
+    std::cerr << out.str() << std::flush;
+}
+
+/**
+ * @brief Function to run main in the interpreter, handing hot functions to a native tier
+ * @return Result of main, 1 on a runtime error
+ */
+static int interpret(const BytecodeProgram& bytecode, ASTNode* ast, const SymbolTable& symbolTable,
+                     const Options& options, std::chrono::steady_clock::time_point startTime, TimeReport& report) {
+    auto phase = report.phase("interp");
+    // native code is at least -O2, it only pays off for code that runs a lot
+    OptLevel level = std::max(options.optLevel, OptLevel::O2);
+    std::unique_ptr<NativeTier> tier;
+    if (options.tierUpCalls) {
+        tier = std::make_unique<NativeTier>(ast, symbolTable, level);
+    }
+    Interpreter interpreter(bytecode, tier.get(), options.tierUpCalls);
+    double ready = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    int32_t result = 0;
+    bool returned = interpreter.run(result);
+    report.setCount("functions_tiered_up", interpreter.tieredUpCount());
+    if (!returned) {
+        return 1;
+    }
+    double finished = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    log::info("Interpreter: main returned {}, {} ms to bytecode, {} ms startup to first result", result, ready,
+              finished);
+    return result;
+}
+
+/**
+ * @brief Function to run everything after the front end on an analyzed and folded program
+ * @param incremental State of an incremental build, null to generate every function
+ */
+static int compileProgram(ASTNode* ast, SymbolTable& symbolTable, IncrementalBuild* incremental,
+                          const std::string& output, const Options& options,
+                          std::chrono::steady_clock::time_point startTime, TimeReport& report) {
+    if (options.interp || options.dumpBytecode) {
+        BytecodeProgram bytecode;
+        {
+            auto phase = report.phase("bytecode");
+            bytecode = compileBytecode(ast, symbolTable);
+        }
+        if (options.dumpBytecode) {
+            printBytecode(bytecode);
+        }
+        if (options.interp) {
+            return interpret(bytecode, ast, symbolTable, options, startTime, report);
+        }
+    }
+
+    // the front end's result, code generation runs when the file is compiled again
+    if (options.emit == EmitKind::AST && !options.run) {
+        auto phase = report.phase("emit");
+        return writeASTFile(ast, symbolTable, output) ? 0 : 1;
+    }
+
+    // the context is declared first so it is destroyed after the module that lives in it
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> module;
+
+    // functions are generated and cleaned up in partitions even on one thread, so the linked
+    // module does not depend on the thread count; this phase covers the cleanup too
+    unsigned codegenThreads = codegenThreadsFor(options);
+    {
+        auto phase = report.phase("codegen");
+        context = std::make_unique<llvm::LLVMContext>();
+        if (incremental) {
+            module = incremental->generate(symbolTable, *context, codegenThreads, options.optLevel);
+        } else {
+            module = generateInParallel(ast, symbolTable, *context, codegenThreads, options.optLevel);
+        }
+        if (!module) {
+            return 1;
+        }
+    }
+    if (incremental) {
+        report.setCount("functions_rebuilt", incremental->rebuiltCount());
+        report.setCount("functions_reused", incremental->reusedCount());
+        report.setCount("functions_stale", incremental->staleCount());
+    }
+    report.setCount("ir_instructions", module->getInstructionCount());
+    log::debug("LLVM IR generated");
+
+    {
+        auto phase = report.phase("verify");
+        std::string errors;
+        llvm::raw_string_ostream errorStream(errors);
+        if (llvm::verifyModule(*module, &errorStream)) {
+            log::error("Module verification failed: {}", errorStream.str());
+            return 1;
+        }
+    }
+
+    std::unique_ptr<llvm::TargetMachine> targetMachine;
+    {
+        auto phase = report.phase("optimize");
+        targetMachine = createHostTargetMachine(options.optLevel);
+        if (targetMachine) {
+            configureModuleForTarget(*module, *targetMachine);
+        }
+        if (incremental) {
+            // functions were optimized alone, callees are only inlined again into stale ones
+            incremental->optimize(*module, options.optLevel);
+        } else {
+            // partitions were only cleaned up, the pipeline runs once over the linked module so
+            // calls across partitions are inlined as in a single module
+            optimizeModule(*module, options.optLevel, targetMachine.get(), options.timePasses);
+        }
+    }
+    report.setCount("ir_instructions_optimized", module->getInstructionCount());
+    log::debug("Optimization pipeline completed");
+
+    if (options.run) {
+        auto phase = report.phase("jit");
+        int result = 0;
+        if (!runJIT(std::move(module), std::move(context), startTime, result)) {
+            return 1;
+        }
+        if (incremental) {
+            incremental->save();
+        }
+        return result;
+    }
+
+    bool written = true;
+    {
+        auto phase = report.phase("emit");
+        switch (options.emit) {
+        case EmitKind::LLVM:
+            written = printLLVMIR(*module, output);
+            break;
+        case EmitKind::Bitcode:
+            written = emitBitcode(*module, output);
+            break;
+        case EmitKind::Assembly:
+        case EmitKind::Object:
+        case EmitKind::Executable:
+            if (!targetMachine) {
+                log::error("No native target available to emit {}", output);
+                return 1;
+            }
+            written = options.emit == EmitKind::Executable
+                ? emitExecutable(*module, *targetMachine, output)
+                : emitNative(*module, *targetMachine, output, options.emit);
+            break;
+        case EmitKind::AST:
+            // written before code generation
+            break;
+        }
+    }
+    if (!written) {
+        return 1;
+    }
+    // a failed compile must not record its functions as built
+    if (incremental) {
+        incremental->save();
+    }
+    return 0;
+}
+
+static int compileSource(std::string_view source, const std::string& output, const Options& options,
+                         std::chrono::steady_clock::time_point startTime, DiagnosticEngine& diagnostics,
+                         TimeReport& report) {
+    // tokens are lexed on demand while parsing, the stream is never held in full
+    Lexer lexer(source);
+    Arena arena;
+    Parser parser(lexer, arena, diagnostics);
+    ASTNode* ast = nullptr;
+    {
+        auto phase = report.phase("parse");
+        ast = parser.parse();
+    }
+    report.setCount("tokens", lexer.tokenCount());
+    report.setCount("ast_nodes", parser.nodeCount());
+    if (diagnostics.hasErrors()) {
+        return 1;
+    }
+    if (options.dumpAST) {
+        printAST(ast);
+    }
+
+    // unchanged functions of an incremental build skip analysis, folding, codegen and optimization
+    std::unique_ptr<IncrementalBuild> incremental;
+    if (options.incremental) {
+        incremental = std::make_unique<IncrementalBuild>(output + ".nvinc", incrementalConfiguration(options));
+    }
+
+    SymbolTable symbolTable;
+    {
+        auto phase = report.phase("analyze");
+        if (incremental) {
+            incremental->analyze(ast, symbolTable, diagnostics);
+        } else {
+            semanticAnalysis(ast, symbolTable, diagnostics);
+        }
+    }
+    if (diagnostics.hasErrors()) {
+        return 1;
+    }
+    log::debug("Semantic analysis completed");
+
+    {
+        auto phase = report.phase("fold");
+        report.setCount("ast_nodes_folded", incremental ? incremental->fold(symbolTable) : foldConstants(ast, symbolTable));
+    }
+    return compileProgram(ast, symbolTable, incremental.get(), output, options, startTime, report);
+}
+
+/**
+ * @brief Function to load a program written by --emit=ast and run the back end on it
+ */
+static int compileSerialized(std::string_view data, const std::string& output, const Options& options,
+                             std::chrono::steady_clock::time_point startTime, TimeReport& report) {
+    Arena arena;
+    SymbolTable symbolTable;
+    ASTNode* ast = nullptr;
+    {
+        auto phase = report.phase("load");
+        ast = loadASTFile(data, arena, symbolTable);
+    }
+    if (options.dumpAST) {
+        printAST(ast);
+    }
+    return compileProgram(ast, symbolTable, nullptr, output, options, startTime, report);
+}
+
+static int runPipeline(const std::string& input, const std::string& output, const Options& options,
+                       std::chrono::steady_clock::time_point startTime, CompilationCache* cache, TimeReport& report) {
+    log::debug("Mapping source file: {}", input);
+    SourceBuffer source;
+    {
+        auto phase = report.phase("read");
+        if (!source.open(input)) {
+            log::error("Failed to open file: {}", input);
+            return 1;
+        }
+    }
+    report.setCount("source_bytes", source.text().size());
+
+    // dumps, --run and --interp need the front end, only plain file outputs are served from the cache
+    std::string cacheKey;
+    if (cache && !options.run && !options.interp && !options.dumpTokens && !options.dumpAST && !options.dumpBytecode) {
+        auto phase = report.phase("cache");
+        cacheKey = CompilationCache::key(source.text(), cacheConfiguration(options));
+        if (cache->fetch(cacheKey, output)) {
+            return 0;
+        }
+    }
+
+    // a serialized AST skips the front end, it was analyzed and folded before it was written
+    bool serialized = isASTFile(source.text());
+    if (serialized && options.incremental) {
+        log::error("{} holds an AST, --incremental needs source files", input);
+        return 1;
+    }
+
+    if (options.dumpTokens && !serialized) {
+        auto phase = report.phase("tokenize");
+        print_tokens(tokenize(source.text()));
+    }
+
+    DiagnosticEngine diagnostics(input, source.text(), options.maxErrors);
+    int status = 1;
+    try {
+        status = serialized ? compileSerialized(source.text(), output, options, startTime, report)
+                            : compileSource(source.text(), output, options, startTime, diagnostics, report);
+    } catch (const CompileError& error) {
+        // raised past the front end, these end the compile at the first error
+        diagnostics.report(error);
+    } catch (const ErrorLimitReached&) {
+        // recorded by the engine, printed with the diagnostics
+    }
+    if (diagnostics.hasErrors()) {
+        printDiagnostics(diagnostics);
+        return 1;
+    }
+
+    if (status == 0 && !cacheKey.empty()) {
+        cache->store(cacheKey, output);
+    }
+    return status;
+}
+
+int compileFile(const std::string& input, const std::string& output, const Options& options,
+                std::chrono::steady_clock::time_point startTime, CompilationCache* cache) {
+    TimeReport report(options.timeReport != TimeReportFormat::None);
+    int status = 1;
+    try {
+        status = runPipeline(input, output, options, startTime, cache, report);
+    } catch (const std::exception& error) {
+        log::error("{}: internal compiler error: {}", input, error.what());
+    }
+
+    if (report.isEnabled()) {
+        // reports of concurrent jobs must not interleave
+        static std::mutex reportMutex;
+        std::lock_guard<std::mutex> lock(reportMutex);
+        report.print(std::cerr, input, options.timeReport);
+    }
+    return status;
+}
+
+static void reportCache(const CompilationCache* cache) {
+    if (cache) {
+        log::info("Cache: {} hits, {} misses, {} evictions", cache->hits(), cache->misses(), cache->evictions());
+    }
+}
+
+int compileAll(const Options& options, std::chrono::steady_clock::time_point startTime, CompilationCache* sharedCache) {
+    std::unique_ptr<CompilationCache> ownedCache;
+    CompilationCache* cache = sharedCache;
+    if (!cache && !options.cacheDir.empty()) {
+        ownedCache = std::make_unique<CompilationCache>(options.cacheDir, options.cacheMaxBytes);
+        cache = ownedCache.get();
+    }
+
+    if (options.inputs.size() == 1) {
+        const std::string& input = options.inputs[0];
+        int status = compileFile(input, outputPathFor(input, options), options, startTime, cache);
+        reportCache(cache);
+        return status;
+    }
+
+    unsigned jobs = options.jobs ? options.jobs : std::thread::hardware_concurrency();
+    if (jobs > options.inputs.size()) jobs = options.inputs.size();
+
+    // files already run in parallel, splitting each of them as well would oversubscribe the cores
+    Options fileOptions = options;
+    if (jobs > 1 && !fileOptions.codegenThreads) {
+        fileOptions.codegenThreads = 1;
+    }
+
+    std::atomic<size_t> failed{0};
+    {
+        ThreadPool pool(jobs);
+        for (const std::string& input : options.inputs) {
+            pool.submit([&, input] {
+                if (compileFile(input, outputPathFor(input, options), fileOptions, startTime, cache) != 0) {
+                    ++failed;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    size_t total = options.inputs.size();
+    log::info("Compiled {}/{} files with {} jobs", total - failed, total, jobs);
+    reportCache(cache);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <chrono>
+#include <string>
+#include "options.h"
+#include "../cache/cache.h"
+
+/**
+ * @brief Function to run the whole pipeline for one input file
+ * @param input Source file
+ * @param output Output path
+ * @param options Parsed options
+ * @param startTime Point in time the compiler started
+ * @param cache Compilation cache, may be null
+ * @return 0 on success, 1 on error, main's result with --run
+ */
+int compileFile(const std::string& input, const std::string& output, const Options& options,
+                std::chrono::steady_clock::time_point startTime, CompilationCache* cache = nullptr);
+
+/**
+ * @brief Function to compile every input, spreading files over a thread pool
+ * @param options Parsed options
+ * @param startTime Point in time the compiler started
+ * @param sharedCache Cache kept by the caller across compiles, null to open options.cacheDir for this call
+ * @return 0 if every file compiled, 1 otherwise, main's result with --run
+ */
+int compileAll(const Options& options, std::chrono::steady_clock::time_point startTime,
+               CompilationCache* sharedCache = nullptr);
+
+#endif // DRIVER_H
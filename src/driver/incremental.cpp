@@ -0,0 +1,399 @@
+#include "incremental.h"
+#include "parallel_codegen.h"
+#include "thread_pool.h"
+#include "../optimizer/fold.h"
+#include "../logger/logger.h"
+#include "../timing/time_report.h"
+#include <llvm/ADT/SCCIterator.h>
+#include <llvm/Analysis/CallGraph.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+// State file, read back by the same binary on the same machine so integers are native-endian:
+//   magic, uint32 size + configuration, uint32 function count, then per function
+//   uint32 size + name, 32-byte fingerprint, uint64 size + bitcode optimized alone,
+//   uint64 size + bitcode after inlining (0 at -O0)
+static constexpr char STATE_MAGIC[8] = {'N', 'V', 'I', 'N', 'C', '0', '0', '3'};
+static constexpr size_t FINGERPRINT_BYTES = 32;
+// callees up to this many instructions are inlined into stale functions, about what the
+// module pipeline's inliner takes at -O2 for code without loops
+static constexpr unsigned INLINE_INSTRUCTION_LIMIT = 50;
+
+static void hashNode(llvm::SHA256& hasher, const ASTNode* root,
+                     const std::unordered_map<std::string_view, std::string>& signatures) {
+    // parents before their children, each with its child count, so the shape is part of the hash
+    forEachNode(root, [&](const ASTNode* node) {
+        uint8_t kind = static_cast<uint8_t>(node->kind);
+        uint32_t childCount = static_cast<uint32_t>(node->children.size());
+        hasher.update(llvm::ArrayRef<uint8_t>(&kind, 1));
+        hasher.update(llvm::StringRef(node->value.data(), node->value.size()));
+        hasher.update(llvm::StringRef("\0", 1)); // keep a value and the next field from running together
+        hasher.update(llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t*>(&childCount), sizeof(childCount)));
+        if (node->kind == NodeKind::Type) {
+            // the length of an array type is the only field besides the text that comes from the source
+            hasher.update(llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t*>(&node->number), sizeof(node->number)));
+        }
+        if (node->kind == NodeKind::Call) {
+            auto callee = signatures.find(node->value);
+            hasher.update(callee == signatures.end() ? llvm::StringRef("?") : llvm::StringRef(callee->second));
+        }
+    });
+}
+
+std::string functionSignature(const SymbolTable& symbolTable, int32_t function) {
+    const Symbol& symbol = symbolTable.getSymbol(function);
+    std::string signature(reinterpret_cast<const char*>(&symbol.arity), sizeof(symbol.arity));
+    for (uint32_t i = 0; i < symbol.arity; ++i) {
+        uint32_t length = symbolTable.parameterLength(function, i);
+        signature.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    }
+    return signature;
+}
+
+std::string fingerprintFunction(const ASTNode* function,
+                                const std::unordered_map<std::string_view, std::string>& signatures) {
+    llvm::SHA256 hasher;
+    hashNode(hasher, function, signatures);
+    return hasher.final().str();
+}
+
+IncrementalBuild::IncrementalBuild(std::string statePath, std::string configuration)
+    : statePath(std::move(statePath)), configuration(std::move(configuration)) {
+    load();
+}
+
+namespace {
+
+/**
+ * @brief Bounds-checked reader over a state file, a truncated file reads as invalid instead of crashing
+ */
+struct StateReader {
+    llvm::StringRef data;
+    bool valid = true;
+
+    template <typename T>
+    T number() {
+        T value{};
+        if (data.size() < sizeof(T)) {
+            valid = false;
+            return value;
+        }
+        std::memcpy(&value, data.data(), sizeof(T));
+        data = data.drop_front(sizeof(T));
+        return value;
+    }
+
+    llvm::StringRef bytes(uint64_t size) {
+        if (data.size() < size) {
+            valid = false;
+            return {};
+        }
+        llvm::StringRef value = data.take_front(size);
+        data = data.drop_front(size);
+        return value;
+    }
+};
+
+} // namespace
+
+void IncrementalBuild::load() {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> file = llvm::MemoryBuffer::getFile(statePath);
+    if (!file) {
+        log::debug("No incremental state at {}, building every function", statePath);
+        return;
+    }
+    StateReader reader{(*file)->getBuffer()};
+    if (reader.bytes(sizeof(STATE_MAGIC)) != llvm::StringRef(STATE_MAGIC, sizeof(STATE_MAGIC))) {
+        log::debug("Ignoring unreadable incremental state {}", statePath);
+        return;
+    }
+    if (reader.bytes(reader.number<uint32_t>()) != configuration) {
+        log::debug("Incremental state {} was built with another configuration", statePath);
+        return;
+    }
+
+    uint32_t count = reader.number<uint32_t>();
+    for (uint32_t i = 0; i < count && reader.valid; ++i) {
+        llvm::StringRef name = reader.bytes(reader.number<uint32_t>());
+        llvm::StringRef fingerprint = reader.bytes(FINGERPRINT_BYTES);
+        llvm::StringRef bitcode = reader.bytes(reader.number<uint64_t>());
+        llvm::StringRef inlined = reader.bytes(reader.number<uint64_t>());
+        if (reader.valid) {
+            stored[name.str()] = {fingerprint.str(), bitcode.str(), inlined.str()};
+        }
+    }
+    if (!reader.valid) {
+        log::debug("Ignoring truncated incremental state {}", statePath);
+        stored.clear();
+    }
+}
+
+void IncrementalBuild::analyze(ASTNode* program, SymbolTable& symbolTable, DiagnosticEngine& diagnostics) {
+    this->program = program;
+    declareFunctions(program, symbolTable, diagnostics);
+
+    std::unordered_map<std::string_view, std::string> signatures;
+    for (const ASTNode* function : program->children) {
+        if (function->symbol >= 0) {
+            signatures[function->value] = functionSignature(symbolTable, function->symbol);
+        }
+    }
+
+    units.clear();
+    rebuilt = 0;
+    for (ASTNode* function : program->children) {
+        // a redefinition has no slot and was reported by declareFunctions
+        if (function->symbol < 0) continue;
+
+        Unit unit{function, fingerprintFunction(function, signatures), {}, {}, false};
+        auto previous = stored.find(std::string(function->value));
+        if (previous != stored.end() && previous->second.fingerprint == unit.fingerprint) {
+            unit.bitcode = std::move(previous->second.bitcode);
+            unit.inlined = std::move(previous->second.inlined);
+            unit.reused = true;
+        } else {
+            semanticAnalysis(function, symbolTable, diagnostics);
+            ++rebuilt;
+        }
+        units.push_back(std::move(unit));
+    }
+    stored.clear();
+    log::debug("Incremental build: {} functions changed, {} reused", rebuilt, units.size() - rebuilt);
+}
+
+size_t IncrementalBuild::fold(const SymbolTable& symbolTable) {
+    size_t removed = 0;
+    for (Unit& unit : units) {
+        if (!unit.reused) {
+            removed += foldConstants(unit.function, symbolTable);
+        }
+    }
+    return removed;
+}
+
+void IncrementalBuild::markStale(OptLevel level) {
+    std::vector<Unit*> pending;
+    for (Unit& unit : units) {
+        unit.stale = !unit.reused;
+        if (unit.stale) pending.push_back(&unit);
+    }
+    // nothing is inlined at -O0, a function's code only depends on its own source
+    if (level != OptLevel::O0) {
+        std::unordered_map<std::string_view, Unit*> byName;
+        for (Unit& unit : units) {
+            byName[unit.function->value] = &unit;
+        }
+        std::unordered_map<const Unit*, std::vector<Unit*>> callers;
+        for (Unit& unit : units) {
+            forEachNode(unit.function, [&](const ASTNode* node) {
+                if (node->kind != NodeKind::Call) return;
+                auto callee = byName.find(node->value);
+                if (callee != byName.end()) callers[callee->second].push_back(&unit);
+            });
+        }
+        // a caller may hold an inlined copy of a stale function, and its own callers a copy of it
+        while (!pending.empty()) {
+            Unit* callee = pending.back();
+            pending.pop_back();
+            for (Unit* caller : callers[callee]) {
+                if (!caller->stale) {
+                    caller->stale = true;
+                    pending.push_back(caller);
+                }
+            }
+        }
+    }
+    stale = std::count_if(units.begin(), units.end(), [](const Unit& unit) { return unit.stale; });
+}
+
+std::unique_ptr<llvm::Module> IncrementalBuild::generate(const SymbolTable& symbolTable, llvm::LLVMContext& context,
+                                                         unsigned threads, OptLevel level) {
+    markStale(level);
+    std::vector<Unit*> pending;
+    for (Unit& unit : units) {
+        if (!unit.reused) pending.push_back(&unit);
+    }
+
+    // every changed function gets a module of its own, so it can be reused alone next time
+    std::vector<std::exception_ptr> errors(pending.size());
+    {
+        ThreadPool pool(static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, pending.size()))));
+        TimeReport::Scope* phase = TimeReport::Scope::current();
+        for (size_t i = 0; i < pending.size(); ++i) {
+            pool.submit([&, i] {
+                TimeReport::Worker measured(phase);
+                try {
+                    llvm::SmallVector<char, 0> bitcode;
+                    generateBitcode({pending[i]->function}, symbolTable, level, true, bitcode);
+                    pending[i]->bitcode.assign(bitcode.data(), bitcode.size());
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        pool.wait();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    // stale functions get their callees inlined again by optimize, the others are final already
+    std::vector<llvm::StringRef> buffers;
+    buffers.reserve(units.size());
+    for (const Unit& unit : units) {
+        buffers.emplace_back(unit.stale || unit.inlined.empty() ? unit.bitcode : unit.inlined);
+    }
+    std::unique_ptr<llvm::Module> linked = linkBitcode(buffers, context);
+    if (linked) {
+        sortFunctions(*linked, program);
+    }
+    return linked;
+}
+
+/**
+ * @brief Function to copy one function of a module into bitcode of its own, with declarations of
+ *        what it calls and the definitions of the runtime it uses
+ */
+static std::string extractFunction(const llvm::Module& module, const llvm::Function& function,
+                                   const std::unordered_map<std::string_view, const ASTNode*>& programFunctions) {
+    llvm::ValueToValueMapTy map;
+    std::unique_ptr<llvm::Module> single = llvm::CloneModule(module, map, [&](const llvm::GlobalValue* value) {
+        llvm::StringRef name = value->getName();
+        return value == &function || !llvm::isa<llvm::Function>(value) ||
+               !programFunctions.count(std::string_view(name.data(), name.size()));
+    });
+
+    // the clone holds every global of the module, drop what the function does not reach
+    bool erased = true;
+    while (erased) {
+        erased = false;
+        for (llvm::Function& other : llvm::make_early_inc_range(*single)) {
+            if (other.getName() != function.getName() && other.use_empty()) {
+                other.eraseFromParent();
+                erased = true;
+            }
+        }
+        for (llvm::GlobalVariable& global : llvm::make_early_inc_range(single->globals())) {
+            global.removeDeadConstantUsers();
+            if (global.use_empty()) {
+                global.eraseFromParent();
+                erased = true;
+            }
+        }
+    }
+
+    std::string bitcode;
+    llvm::raw_string_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(*single, stream);
+    stream.flush();
+    return bitcode;
+}
+
+void IncrementalBuild::optimize(llvm::Module& module, OptLevel level) {
+    if (level == OptLevel::O0) {
+        return;
+    }
+    std::unordered_map<std::string_view, const ASTNode*> programFunctions;
+    std::unordered_map<std::string_view, Unit*> staleUnits;
+    for (Unit& unit : units) {
+        programFunctions[unit.function->value] = unit.function;
+        if (unit.stale) staleUnits[unit.function->value] = &unit;
+    }
+    auto unitOf = [&](const llvm::Function& function) -> Unit* {
+        auto unit = staleUnits.find(std::string_view(function.getName().data(), function.getName().size()));
+        return unit == staleUnits.end() ? nullptr : unit->second;
+    };
+
+    // callees before their callers; functions calling each other are never inlined into one
+    // another, so the result does not depend on which of them was stale
+    std::unordered_map<const llvm::Function*, size_t> sccOf;
+    std::vector<llvm::Function*> pending;
+    {
+        llvm::CallGraph callGraph(module);
+        size_t index = 0;
+        for (auto scc = llvm::scc_begin(&callGraph); !scc.isAtEnd(); ++scc, ++index) {
+            for (llvm::CallGraphNode* node : *scc) {
+                llvm::Function* function = node->getFunction();
+                if (!function) continue;
+                sccOf[function] = index;
+                if (!function->isDeclaration() && unitOf(*function)) pending.push_back(function);
+            }
+        }
+    }
+
+    for (llvm::Function* function : pending) {
+        std::vector<llvm::CallBase*> calls;
+        for (llvm::Instruction& instruction : llvm::instructions(*function)) {
+            auto* call = llvm::dyn_cast<llvm::CallBase>(&instruction);
+            llvm::Function* callee = call ? call->getCalledFunction() : nullptr;
+            if (callee && !callee->isDeclaration() && !callee->isInterposable() &&
+                sccOf[callee] < sccOf[function] && callee->getInstructionCount() <= INLINE_INSTRUCTION_LIMIT) {
+                calls.push_back(call);
+            }
+        }
+        for (llvm::CallBase* call : calls) {
+            llvm::InlineFunctionInfo info;
+            llvm::InlineFunction(*call, info);
+        }
+        cleanupFunctions({function}, level);
+    }
+
+    for (llvm::Function* function : pending) {
+        unitOf(*function)->inlined = extractFunction(module, *function, programFunctions);
+    }
+    // intrinsics the inliner declared and the cleanup left unused, reused bitcode no longer has them
+    for (llvm::Function& function : llvm::make_early_inc_range(module)) {
+        if (function.isDeclaration() && function.use_empty()) {
+            function.eraseFromParent();
+        }
+    }
+    log::debug("Incremental build: inlined callees into {} functions", pending.size());
+}
+
+bool IncrementalBuild::save() const {
+    // written to a temporary and renamed, an interrupted run must not leave a truncated state behind
+    std::string temporary = statePath + ".tmp";
+    {
+        std::error_code error;
+        llvm::raw_fd_ostream out(temporary, error);
+        if (error) {
+            log::warn("Could not write incremental state {}: {}", temporary, error.message());
+            return false;
+        }
+        auto number = [&out](auto value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+        out.write(STATE_MAGIC, sizeof(STATE_MAGIC));
+        number(static_cast<uint32_t>(configuration.size()));
+        out << configuration;
+        number(static_cast<uint32_t>(units.size()));
+        for (const Unit& unit : units) {
+            number(static_cast<uint32_t>(unit.function->value.size()));
+            out << llvm::StringRef(unit.function->value.data(), unit.function->value.size());
+            out << unit.fingerprint;
+            number(static_cast<uint64_t>(unit.bitcode.size()));
+            out << unit.bitcode;
+            number(static_cast<uint64_t>(unit.inlined.size()));
+            out << unit.inlined;
+        }
+        out.close();
+        if (out.has_error()) {
+            log::warn("Could not write incremental state {}: {}", temporary, out.error().message());
+            out.clear_error();
+            llvm::sys::fs::remove(temporary);
+            return false;
+        }
+    }
+    if (llvm::sys::fs::rename(temporary, statePath)) {
+        llvm::sys::fs::remove(temporary);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "../parser/parser.h"
+#include "../analysis/analysis.h"
+#include "../optimizer/optimizer.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Function to encode a function's signature, its arity and the array length of each parameter
+ * @param symbolTable Table the function was declared in
+ * @param function Slot of the function
+ * @return Raw bytes, equal for equal signatures
+ */
+std::string functionSignature(const SymbolTable& symbolTable, int32_t function);
+
+/**
+ * @brief Function to fingerprint a function for incremental builds. Covers the function's
+ *        tokens as parsed (so whitespace does not count) and the signature of every function it
+ *        calls, so callers are rebuilt when a callee's signature changes.
+ * @param function Function node, before constant folding
+ * @param signatures Signature of every function of the program by name, see functionSignature
+ * @return SHA-256 digest, raw bytes
+ */
+std::string fingerprintFunction(const ASTNode* function,
+                                const std::unordered_map<std::string_view, std::string>& signatures);
+
+/**
+ * @brief One incremental compile of a program. Functions whose fingerprint matches the state
+ *        saved by the previous run reuse that run's bitcode and skip analysis, folding, code
+ *        generation and optimization; only the others are compiled, each into a module of its
+ *        own that runs the whole pipeline alone, and everything is linked into one module.
+ *        Above -O0 small callees are then inlined into the functions that changed and into
+ *        their callers, direct or not, in place of the module pipeline; every other function
+ *        reuses the bitcode it had after that step last time. Both steps give the same code
+ *        whatever was rebuilt before, so the output only depends on the source.
+ */
+class IncrementalBuild {
+public:
+    /**
+     * @param statePath File the fingerprints and bitcode are kept in between runs
+     * @param configuration Everything besides the source that changes the bitcode,
+     *        a state saved under another configuration is not reused
+     */
+    IncrementalBuild(std::string statePath, std::string configuration);
+
+    /**
+     * @brief Function to declare every function and analyze the ones that changed
+     * @param program Program node
+     * @param symbolTable Symbol table
+     * @param diagnostics Collects the errors
+     * @throws ErrorLimitReached once the diagnostics hold their maximum number of errors
+     */
+    void analyze(ASTNode* program, SymbolTable& symbolTable, DiagnosticEngine& diagnostics);
+
+    /**
+     * @brief Function to fold constants in the functions that changed
+     * @return Number of nodes removed
+     * @throws CompileError see foldConstants
+     */
+    size_t fold(const SymbolTable& symbolTable);
+
+    /**
+     * @brief Function to generate and optimize the functions that changed and link them with the reused ones
+     * @param symbolTable Table the program was analyzed against
+     * @param context Context the linked module is created in
+     * @param threads Threads compiling changed functions
+     * @param level Optimization level
+     * @return Linked module with its functions sorted, null if linking failed
+     * @throws CompileError raised while generating a function
+     */
+    std::unique_ptr<llvm::Module> generate(const SymbolTable& symbolTable, llvm::LLVMContext& context,
+                                           unsigned threads, OptLevel level);
+
+    /**
+     * @brief Function to inline small callees into the functions that changed and their callers,
+     *        callees first, and keep the result of each for the next run. Does nothing at -O0.
+     * @param module Module returned by generate
+     * @param level Optimization level
+     */
+    void optimize(llvm::Module& module, OptLevel level);
+
+    /**
+     * @brief Function to write the fingerprints and bitcode of every function for the next run,
+     *        only once the compile succeeded
+     * @return false if the state file could not be written
+     */
+    bool save() const;
+
+    size_t rebuiltCount() const { return rebuilt; }
+    size_t reusedCount() const { return units.size() - rebuilt; }
+    size_t staleCount() const { return stale; }
+
+private:
+    struct Unit {
+        ASTNode* function;
+        std::string fingerprint;
+        std::string bitcode; // optimized alone, empty until generated unless reused
+        std::string inlined; // after callees were inlined into it, empty at -O0
+        bool reused;
+        bool stale = false; // changed, or calls a function that did, its callees are inlined again
+    };
+    struct StoredFunction {
+        std::string fingerprint;
+        std::string bitcode;
+        std::string inlined;
+    };
+
+    void load();
+    void markStale(OptLevel level);
+
+    std::string statePath;
+    std::string configuration;
+    std::unordered_map<std::string, StoredFunction> stored;
+    ASTNode* program = nullptr;
+    std::vector<Unit> units;
+    size_t rebuilt = 0;
+    size_t stale = 0;
+};
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,210 @@
+#include "options.h"
+#include "version.h"
+#include "../logger/logger.h"
+#include <cstdlib>
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--run") {
+            options.run = true;
+        } else if (arg == "--interp") {
+            options.interp = true;
+        } else if (arg.rfind("--tier-up=", 0) == 0) {
+            options.tierUpCalls = std::strtoul(arg.c_str() + 10, nullptr, 10);
+        } else if (arg == "-O0") {
+            options.optLevel = OptLevel::O0;
+        } else if (arg == "-O1") {
+            options.optLevel = OptLevel::O1;
+        } else if (arg == "-O2") {
+            options.optLevel = OptLevel::O2;
+        } else if (arg == "-O3") {
+            options.optLevel = OptLevel::O3;
+        } else if (arg == "--dump-tokens") {
+            options.dumpTokens = true;
+        } else if (arg == "--dump-ast") {
+            options.dumpAST = true;
+        } else if (arg == "--dump-bytecode") {
+            options.dumpBytecode = true;
+        } else if (arg == "-j") {
+            if (i + 1 >= argc) {
+                log::error("Missing job count after -j");
+                return false;
+            }
+            options.jobs = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+            options.jobs = std::strtoul(arg.c_str() + 2, nullptr, 10);
+        } else if (arg.rfind("--codegen-threads=", 0) == 0) {
+            options.codegenThreads = std::strtoul(arg.c_str() + 18, nullptr, 10);
+            if (options.codegenThreads == 0) {
+                log::error("Invalid thread count: {}", arg.substr(18));
+                return false;
+            }
+        } else if (arg == "--cache-dir" || arg.rfind("--cache-dir=", 0) == 0) {
+            if (arg == "--cache-dir") {
+                if (i + 1 >= argc) {
+                    log::error("Missing directory after --cache-dir");
+                    return false;
+                }
+                options.cacheDir = argv[++i];
+            } else {
+                options.cacheDir = arg.substr(12);
+            }
+        } else if (arg.rfind("--cache-max-size=", 0) == 0) {
+            options.cacheMaxBytes = std::strtoull(arg.c_str() + 17, nullptr, 10) * 1024 * 1024;
+        } else if (arg == "--incremental") {
+            options.incremental = true;
+        } else if (arg.rfind("--max-errors=", 0) == 0) {
+            options.maxErrors = std::strtoul(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            LogLevel level;
+            if (!log::parseLevel(arg.substr(12), level)) {
+                log::error("Unknown log level: {}", arg.substr(12));
+                return false;
+            }
+            log::setLevel(level);
+        } else if (arg == "--version") {
+            options.version = true;
+            return true;
+        } else if (arg == "--server") {
+            options.server = true;
+        } else if (arg == "--client") {
+            options.client = true;
+        } else if (arg.rfind("--socket=", 0) == 0) {
+            options.socketPath = arg.substr(9);
+        } else if (arg == "--time-report" || arg == "--time-report=text") {
+            options.timeReport = TimeReportFormat::Text;
+        } else if (arg == "--time-report=json") {
+            options.timeReport = TimeReportFormat::JSON;
+        } else if (arg == "--time-passes") {
+            options.timePasses = true;
+        } else if (arg == "-c") {
+            options.emit = EmitKind::Object;
+        } else if (arg == "-S") {
+            options.emit = EmitKind::Assembly;
+        } else if (arg.rfind("--emit=", 0) == 0) {
+            std::string kind = arg.substr(7);
+            if (kind == "ll") {
+                options.emit = EmitKind::LLVM;
+            } else if (kind == "bc") {
+                options.emit = EmitKind::Bitcode;
+            } else if (kind == "asm") {
+                options.emit = EmitKind::Assembly;
+            } else if (kind == "obj") {
+                options.emit = EmitKind::Object;
+            } else if (kind == "exe") {
+                options.emit = EmitKind::Executable;
+            } else if (kind == "ast") {
+                options.emit = EmitKind::AST;
+            } else {
+                log::error("Unknown emit kind: {}", kind);
+                return false;
+            }
+        } else if (arg == "-o") {
+            if (i + 1 >= argc) {
+                log::error("Missing file name after -o");
+                return false;
+            }
+            options.output = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            log::error("Unknown option: {}", arg);
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    if (options.server) {
+        if (options.client || !options.inputs.empty()) {
+            log::error("--server takes no input files");
+            return false;
+        }
+        return true;
+    }
+    if (options.inputs.empty()) {
+        log::error("No input file provided as argument");
+        return false;
+    }
+    if (options.inputs.size() > 1 && !options.output.empty()) {
+        log::error("-o cannot be used with multiple input files");
+        return false;
+    }
+    if (options.inputs.size() > 1 && (options.run || options.interp)) {
+        log::error("{} takes a single input file", options.run ? "--run" : "--interp");
+        return false;
+    }
+    if (options.run && options.interp) {
+        log::error("--run and --interp cannot be combined");
+        return false;
+    }
+    if ((options.interp || options.dumpBytecode) && options.incremental) {
+        // an incremental build skips analysis of unchanged functions, bytecode needs all of them
+        log::error("{} cannot be combined with --incremental", options.interp ? "--interp" : "--dump-bytecode");
+        return false;
+    }
+    if (options.emit == EmitKind::AST && options.incremental) {
+        // unchanged functions are not analyzed, there is no complete program to write
+        log::error("--emit=ast cannot be combined with --incremental");
+        return false;
+    }
+    return true;
+}
+
+std::string outputPathFor(const std::string& input, const Options& options) {
+    if (options.inputs.size() == 1) {
+        return options.output.empty() ? defaultOutputName(options.emit) : options.output;
+    }
+
+    std::string extension;
+    switch (options.emit) {
+        case EmitKind::LLVM: extension = ".ll"; break;
+        case EmitKind::Bitcode: extension = ".bc"; break;
+        case EmitKind::Assembly: extension = ".s"; break;
+        case EmitKind::Object: extension = ".o"; break;
+        case EmitKind::Executable: extension = ""; break;
+        case EmitKind::AST: extension = ".nvast"; break;
+    }
+
+    size_t slash = input.find_last_of('/');
+    size_t dot = input.find_last_of('.');
+    std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? input.substr(0, dot) : input;
+    return stem + extension;
+}
+
+void printVersion() {
+    std::cout << "cts " << NOVA_VERSION << std::endl;
+}
+
+void printUsage() {
+    std::cout << "Usage: cts [options] <file.nv|file.nvast>...\n"
+              << "  -o <file>     Write the output to <file> (default: output.ll, .bc, .s, .o, .nvast or output)\n"
+              << "  --emit=<kind> Output kind: ll (default), bc, asm, obj, exe or ast; an ast file is\n"
+              << "                analyzed and folded, compiling it again skips the front end\n"
+              << "  -S            Same as --emit=asm\n"
+              << "  -c            Same as --emit=obj\n"
+              << "  -O0..-O3      Optimization level (default: -O0)\n"
+              << "  --time-passes Print the time spent in each optimization pass\n"
+              << "  --time-report[=text|json]  Print per-phase time, allocations and peak RSS to stderr\n"
+              << "  --run         JIT-compile and run main, its result becomes the exit code\n"
+              << "  --interp      Run main in the bytecode interpreter, its result becomes the exit code\n"
+              << "  --tier-up=<n> With --interp, JIT-compile a function after <n> calls, 0 never (default: 1000)\n"
+              << "  -j <n>        Compile up to <n> input files in parallel (default: all cores)\n"
+              << "  --codegen-threads=<n>  Generate the functions of a file on <n> threads\n"
+              << "                         (default: all cores for a single input, 1 with several)\n"
+              << "  --max-errors=<n>       Stop after <n> errors per file, 0 for no limit (default: 20)\n"
+              << "  --dump-tokens Print the token stream\n"
+              << "  --dump-ast    Print the AST\n"
+              << "  --dump-bytecode        Print the bytecode --interp runs\n"
+              << "  --incremental          Keep per-function bitcode in <output>.nvinc and only recompile\n"
+              << "                         functions that changed since the last run\n"
+              << "  --cache-dir <dir>      Reuse outputs of identical earlier compiles from <dir>\n"
+              << "  --cache-max-size=<MB>  Evict least recently used cache entries above this size (default: 1024)\n"
+              << "  --log-level=<level>    debug, info (default), warn, error or none\n"
+              << "  --server      Serve compiles on a Unix socket, keeping LLVM and caches warm\n"
+              << "  --client      Forward this compile to a running --server, compiles in-process if none listens\n"
+              << "  --socket=<path>        Socket of --server and --client (default: $XDG_RUNTIME_DIR/cts.sock)\n"
+              << "  --version     Print the compiler version\n";
+}
@@ -0,0 +1,63 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../optimizer/optimizer.h"
+#include "../emit/emit.h"
+#include "../timing/time_report.h"
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string output; // single input only, defaults to defaultOutputName(emit)
+    EmitKind emit = EmitKind::LLVM;
+    bool run = false; // JIT the module and execute main in-process
+    bool interp = false; // execute main in the bytecode interpreter, without code generation
+    uint32_t tierUpCalls = 1000; // calls before --interp hands a function to the JIT, 0 never
+    OptLevel optLevel = OptLevel::O0;
+    bool timePasses = false;
+    TimeReportFormat timeReport = TimeReportFormat::None;
+    bool dumpTokens = false;
+    bool dumpAST = false;
+    bool dumpBytecode = false;
+    size_t maxErrors = 20; // errors reported per file before giving up, 0 for no limit
+    unsigned jobs = 0; // 0 picks the number of hardware threads
+    unsigned codegenThreads = 0; // threads generating one file's functions, 0 picks the hardware threads
+    bool incremental = false; // reuse unchanged functions from the state saved next to the output
+    std::string cacheDir; // empty disables the compilation cache
+    uint64_t cacheMaxBytes = 1024ull * 1024 * 1024;
+    bool version = false; // print the version and exit, the rest of the command line is ignored
+    bool server = false;  // serve compile requests on socketPath instead of compiling
+    bool client = false;  // forward the compile to the server on socketPath
+    std::string socketPath; // empty picks defaultSocketPath()
+};
+
+/**
+ * @brief Function to parse the command line
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param options Parsed options
+ * @return false if the command line is invalid
+ */
+bool parseOptions(int argc, char** argv, Options& options);
+
+/**
+ * @brief Function to get the output path for an input
+ * @param input Input file
+ * @param options Parsed options
+ * @return The -o path or default name for a single input, otherwise the input with the emit kind's extension
+ */
+std::string outputPathFor(const std::string& input, const Options& options);
+
+/**
+ * @brief Function to print the compiler version
+ */
+void printVersion();
+
+/**
+ * @brief Function to print the command line usage
+ */
+void printUsage();
+
+#endif // OPTIONS_H
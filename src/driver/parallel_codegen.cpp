@@ -0,0 +1,164 @@
+#include "parallel_codegen.h"
+#include "thread_pool.h"
+#include "../llvm/llvm_generator.h"
+#include "../target/target.h"
+#include "../logger/logger.h"
+#include "../timing/time_report.h"
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+namespace {
+
+struct Partition {
+    std::vector<ASTNode*> functions;
+    size_t weight = 0;
+    llvm::SmallVector<char, 0> bitcode;
+    std::exception_ptr error;
+};
+
+size_t countNodes(const ASTNode* node) {
+    size_t count = 0;
+    forEachNode(node, [&](const ASTNode*) { ++count; });
+    return count;
+}
+
+/**
+ * @brief Function to spread functions over partitions, largest first onto the lightest partition
+ */
+std::vector<Partition> partitionFunctions(ASTNode* program, size_t count) {
+    std::vector<std::pair<size_t, ASTNode*>> weighted;
+    weighted.reserve(program->children.size());
+    for (ASTNode* function : program->children) {
+        weighted.emplace_back(countNodes(function), function);
+    }
+    std::stable_sort(weighted.begin(), weighted.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<Partition> partitions(count);
+    for (const auto& [weight, function] : weighted) {
+        Partition& lightest = *std::min_element(partitions.begin(), partitions.end(),
+                                                [](const Partition& a, const Partition& b) { return a.weight < b.weight; });
+        lightest.functions.push_back(function);
+        lightest.weight += weight;
+    }
+    return partitions;
+}
+
+} // namespace
+
+void generateBitcode(const std::vector<ASTNode*>& functions, const SymbolTable& symbolTable, OptLevel level,
+                     bool optimize, llvm::SmallVectorImpl<char>& bitcode) {
+    // the module only lives until it is serialized, so each worker keeps its generator and
+    // context for the next function instead of creating a context per module
+    thread_local CodeGenerator generator;
+    generator.reset();
+    for (ASTNode* function : functions) {
+        generator.generate(function, symbolTable);
+    }
+    llvm::Module& module = generator.module();
+
+    std::unique_ptr<llvm::TargetMachine> targetMachine = createHostTargetMachine(level);
+    if (targetMachine) {
+        configureModuleForTarget(module, *targetMachine);
+    }
+    if (optimize) {
+        optimizeModule(module, level, targetMachine.get(), false);
+    } else {
+        cleanupFunctions(module, level);
+    }
+
+    llvm::raw_svector_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(module, stream);
+}
+
+std::unique_ptr<llvm::Module> linkBitcode(const std::vector<llvm::StringRef>& buffers, llvm::LLVMContext& context) {
+    std::unique_ptr<llvm::Module> linked;
+    for (llvm::StringRef buffer : buffers) {
+        llvm::Expected<std::unique_ptr<llvm::Module>> module =
+            llvm::parseBitcodeFile(llvm::MemoryBufferRef(buffer, "partition"), context);
+        if (!module) {
+            log::error("Failed to read partition bitcode: {}", llvm::toString(module.takeError()));
+            return nullptr;
+        }
+        if (!linked) {
+            linked = std::move(*module);
+            // named after the buffer otherwise, the generator's name is kept as the source file name
+            linked->setModuleIdentifier(linked->getSourceFileName());
+        } else if (llvm::Linker::linkModules(*linked, std::move(*module))) {
+            log::error("Failed to link codegen partitions");
+            return nullptr;
+        }
+    }
+    return linked;
+}
+
+void sortFunctions(llvm::Module& module, const ASTNode* program) {
+    std::vector<llvm::Function*> defined;
+    llvm::SmallPtrSet<llvm::Function*, 32> inProgram;
+    for (const ASTNode* node : program->children) {
+        llvm::Function* function = module.getFunction(llvm::StringRef(node->value.data(), node->value.size()));
+        if (function && inProgram.insert(function).second) {
+            defined.push_back(function);
+        }
+    }
+    std::vector<llvm::Function*> others;
+    for (llvm::Function& function : module) {
+        if (!inProgram.count(&function)) {
+            others.push_back(&function);
+        }
+    }
+    std::sort(others.begin(), others.end(),
+              [](const llvm::Function* a, const llvm::Function* b) { return a->getName() < b->getName(); });
+
+    // moved to the back one by one, so the list ends up in this order
+    for (std::vector<llvm::Function*>* group : {&others, &defined}) {
+        for (llvm::Function* function : *group) {
+            function->removeFromParent();
+            module.getFunctionList().push_back(function);
+        }
+    }
+}
+
+std::unique_ptr<llvm::Module> generateInParallel(ASTNode* program, const SymbolTable& symbolTable,
+                                                 llvm::LLVMContext& context, unsigned threads, OptLevel level) {
+    size_t count = std::max<size_t>(1, std::min<size_t>(threads, program->children.size()));
+    std::vector<Partition> partitions = partitionFunctions(program, count);
+
+    {
+        ThreadPool pool(static_cast<unsigned>(count));
+        TimeReport::Scope* phase = TimeReport::Scope::current();
+        for (Partition& partition : partitions) {
+            pool.submit([&partition, &symbolTable, level, phase] {
+                TimeReport::Worker measured(phase);
+                try {
+                    generateBitcode(partition.functions, symbolTable, level, false, partition.bitcode);
+                } catch (...) {
+                    partition.error = std::current_exception();
+                }
+            });
+        }
+        pool.wait();
+    }
+    for (const Partition& partition : partitions) {
+        if (partition.error) std::rethrow_exception(partition.error);
+    }
+
+    std::vector<llvm::StringRef> buffers;
+    for (const Partition& partition : partitions) {
+        buffers.emplace_back(partition.bitcode.data(), partition.bitcode.size());
+    }
+    std::unique_ptr<llvm::Module> linked = linkBitcode(buffers, context);
+    if (linked) {
+        sortFunctions(*linked, program);
+    }
+    log::debug("Generated {} functions in {} partitions", program->children.size(), count);
+    return linked;
+}
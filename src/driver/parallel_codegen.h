@@ -0,0 +1,60 @@
+#ifndef PARALLEL_CODEGEN_H
+#define PARALLEL_CODEGEN_H
+
+#include "../parser/parser.h"
+#include "../analysis/analysis.h"
+#include "../optimizer/optimizer.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Function to generate functions into a module of their own, clean them up and serialize it
+ * @param functions Function nodes, resolved by semanticAnalysis
+ * @param symbolTable Table the functions were resolved against
+ * @param level Optimization level, see cleanupFunctions
+ * @param optimize Run the whole pipeline on the functions alone instead of the cleanup
+ * @param bitcode Receives the module as bitcode, callees outside functions are left as declarations
+ * @throws CompileError raised while generating the functions
+ */
+void generateBitcode(const std::vector<ASTNode*>& functions, const SymbolTable& symbolTable, OptLevel level,
+                     bool optimize, llvm::SmallVectorImpl<char>& bitcode);
+
+/**
+ * @brief Function to read bitcode modules and link them into one
+ * @param buffers Bitcode of each module, linked in order
+ * @param context Context the linked module is created in
+ * @return Linked module, null if a buffer could not be read or linked
+ */
+std::unique_ptr<llvm::Module> linkBitcode(const std::vector<llvm::StringRef>& buffers, llvm::LLVMContext& context);
+
+/**
+ * @brief Function to put a module's functions in a fixed order: everything the program does not
+ *        define sorted by name, then the program's functions in source order, so linked partitions
+ *        end up alike whatever the partitioning.
+ * @param module Module holding the program's functions
+ * @param program Program node the module was generated from
+ */
+void sortFunctions(llvm::Module& module, const ASTNode* program);
+
+/**
+ * @brief Function to generate the functions of a program on one or more threads. Functions are
+ *        split into partitions of similar AST size; every partition is generated and cleaned
+ *        up in its own LLVMContext, serialized to bitcode and the partitions are linked into
+ *        one module afterwards. The module pipeline is left to the caller, it runs once on the
+ *        linked module so calls across partitions are inlined as in a single module.
+ * @param program Program node, resolved by semanticAnalysis
+ * @param symbolTable Table the program was resolved against
+ * @param context Context the linked module is created in
+ * @param threads Worker threads, one partition per thread at most
+ * @param level Optimization level, see cleanupFunctions
+ * @return Linked module with its functions sorted, null if the partitions could not be linked
+ * @throws CompileError raised while generating any of the partitions
+ */
+std::unique_ptr<llvm::Module> generateInParallel(ASTNode* program, const SymbolTable& symbolTable,
+                                                 llvm::LLVMContext& context, unsigned threads, OptLevel level);
+
+#endif // PARALLEL_CODEGEN_H
@@ -0,0 +1,7 @@
+#ifndef VERSION_H
+#define VERSION_H
+
+// bump whenever the generated code can change, it is part of every cache key
+#define NOVA_VERSION "0.2.1"
+
+#endif // VERSION_H
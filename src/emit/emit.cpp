@@ -0,0 +1,99 @@
+#include "emit.h"
+#include "../logger/logger.h"
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+
+const char* defaultOutputName(EmitKind kind) {
+    switch (kind) {
+        case EmitKind::LLVM: return "output.ll";
+        case EmitKind::Bitcode: return "output.bc";
+        case EmitKind::Assembly: return "output.s";
+        case EmitKind::Object: return "output.o";
+        case EmitKind::Executable: return "output";
+        case EmitKind::AST: return "output.nvast";
+    }
+    return "output";
+}
+
+bool emitBitcode(const llvm::Module& module, const std::string& filename) {
+    log::debug("Writing bitcode to file: {}", filename);
+    std::error_code EC;
+    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+        log::error("Could not open file {}: {}", filename, EC.message());
+        return false;
+    }
+    llvm::WriteBitcodeToFile(module, dest);
+    dest.close();
+    if (dest.has_error()) {
+        log::error("Could not write file {}: {}", filename, dest.error().message());
+        dest.clear_error();
+        return false;
+    }
+    return true;
+}
+
+bool emitNative(llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& filename, EmitKind kind) {
+    log::debug("Writing native code to file: {}", filename);
+    std::error_code EC;
+    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+        log::error("Could not open file {}: {}", filename, EC.message());
+        return false;
+    }
+    bool emitted = emitNative(module, targetMachine, dest, kind);
+    dest.close();
+    if (dest.has_error()) {
+        log::error("Could not write file {}: {}", filename, dest.error().message());
+        dest.clear_error();
+        return false;
+    }
+    return emitted;
+}
+
+bool emitNative(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_pwrite_stream& dest, EmitKind kind) {
+    llvm::CodeGenFileType fileType = kind == EmitKind::Assembly ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile;
+    llvm::legacy::PassManager passes;
+    if (targetMachine.addPassesToEmitFile(passes, dest, nullptr, fileType)) {
+        log::error("Target cannot emit this file type");
+        return false;
+    }
+    passes.run(module);
+    dest.flush();
+    return true;
+}
+
+bool emitExecutable(llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& filename) {
+    llvm::SmallString<128> objectFile;
+    if (auto EC = llvm::sys::fs::createTemporaryFile("cts", "o", objectFile)) {
+        log::error("Could not create temporary object file: {}", EC.message());
+        return false;
+    }
+
+    bool linked = false;
+    if (emitNative(module, targetMachine, objectFile.str().str(), EmitKind::Object)) {
+        auto linker = llvm::sys::findProgramByName("cc");
+        if (!linker) {
+            log::error("Could not find the system linker driver 'cc'");
+        } else {
+            std::string linkerPath = *linker;
+            std::string object = objectFile.str().str();
+            llvm::SmallVector<llvm::StringRef, 8> args = {linkerPath, object, "-o", filename};
+            log::debug("Linking: {} {} -o {}", linkerPath, object, filename);
+
+            std::string error;
+            int status = llvm::sys::ExecuteAndWait(linkerPath, args, llvm::None, {}, 0, 0, &error);
+            if (status != 0) {
+                log::error("Linking failed{}{}", error.empty() ? "" : ": ", error);
+            } else {
+                linked = true;
+            }
+        }
+    }
+
+    llvm::sys::fs::remove(objectFile);
+    return linked;
+}
@@ -0,0 +1,62 @@
+#ifndef EMIT_H
+#define EMIT_H
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <string>
+
+enum class EmitKind {
+    LLVM,       // textual IR (.ll)
+    Bitcode,    // LLVM bitcode (.bc)
+    Assembly,   // native assembly (.s)
+    Object,     // native object file (.o)
+    Executable, // object file linked by the system linker
+    AST         // analyzed and folded program (.nvast), see serialize/ast_file.h
+};
+
+/**
+ * @brief Function to get the default output file name for an emit kind
+ * @param kind Emit kind
+ * @return File name
+ */
+const char* defaultOutputName(EmitKind kind);
+
+/**
+ * @brief Function to write a module as LLVM bitcode
+ * @param module Module to write
+ * @param filename Output path
+ * @return false if the file could not be written
+ */
+bool emitBitcode(const llvm::Module& module, const std::string& filename);
+
+/**
+ * @brief Function to run the backend and write native code straight from memory
+ * @param module Module to compile, must be configured for targetMachine
+ * @param targetMachine Target to generate code for
+ * @param filename Output path
+ * @param kind Either EmitKind::Assembly or EmitKind::Object
+ * @return false if the target cannot emit the file type or the file could not be written
+ */
+bool emitNative(llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& filename, EmitKind kind);
+
+/**
+ * @brief Function to run the backend into a stream, e.g. an llvm::raw_svector_ostream to keep the code in memory
+ * @param module Module to compile, must be configured for targetMachine
+ * @param targetMachine Target to generate code for
+ * @param dest Stream the code is written to
+ * @param kind Either EmitKind::Assembly or EmitKind::Object
+ * @return false if the target cannot emit the file type
+ */
+bool emitNative(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::raw_pwrite_stream& dest, EmitKind kind);
+
+/**
+ * @brief Function to compile a module to an object file and link it with the system linker
+ * @param module Module to compile, must be configured for targetMachine
+ * @param targetMachine Target to generate code for
+ * @param filename Output executable path
+ * @return false if compiling or linking failed
+ */
+bool emitExecutable(llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& filename);
+
+#endif // EMIT_H
@@ -0,0 +1,416 @@
+#include "bytecode.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+const char* opcodeName(Opcode op) {
+    switch (op) {
+        case Opcode::LoadConst: return "loadconst";
+        case Opcode::Move: return "move";
+        case Opcode::Add: return "add";
+        case Opcode::Subtract: return "sub";
+        case Opcode::Multiply: return "mul";
+        case Opcode::Divide: return "div";
+        case Opcode::Less: return "lt";
+        case Opcode::LessEqual: return "le";
+        case Opcode::Greater: return "gt";
+        case Opcode::GreaterEqual: return "ge";
+        case Opcode::Equal: return "eq";
+        case Opcode::NotEqual: return "ne";
+        case Opcode::Jump: return "jump";
+        case Opcode::JumpIfZero: return "jz";
+        case Opcode::JumpIfNotZero: return "jnz";
+        case Opcode::JumpLess: return "jlt";
+        case Opcode::JumpLessEqual: return "jle";
+        case Opcode::JumpGreater: return "jgt";
+        case Opcode::JumpGreaterEqual: return "jge";
+        case Opcode::JumpEqual: return "jeq";
+        case Opcode::JumpNotEqual: return "jne";
+        case Opcode::ArrayAddress: return "arrayaddr";
+        case Opcode::ZeroArray: return "zeroarray";
+        case Opcode::LoadElement: return "loadelem";
+        case Opcode::StoreElement: return "storeelem";
+        case Opcode::Call: return "call";
+        case Opcode::Return: return "ret";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// keeps a frame well inside the interpreter's register stack
+constexpr uint32_t MAX_FRAME_REGISTERS = 1u << 20;
+// literals beyond this many distinct values are loaded where they are used
+constexpr size_t MAX_CONSTANT_REGISTERS = 256;
+
+Opcode arithmeticOpcode(BinaryOperator op) {
+    switch (op) {
+        case BinaryOperator::Add: return Opcode::Add;
+        case BinaryOperator::Subtract: return Opcode::Subtract;
+        case BinaryOperator::Multiply: return Opcode::Multiply;
+        case BinaryOperator::Divide: return Opcode::Divide;
+        case BinaryOperator::Less: return Opcode::Less;
+        case BinaryOperator::LessEqual: return Opcode::LessEqual;
+        case BinaryOperator::Greater: return Opcode::Greater;
+        case BinaryOperator::GreaterEqual: return Opcode::GreaterEqual;
+        case BinaryOperator::Equal: return Opcode::Equal;
+        case BinaryOperator::NotEqual: return Opcode::NotEqual;
+    }
+    return Opcode::Add;
+}
+
+/**
+ * @brief Function to get the jump taken when a comparison holds, or when it does not
+ */
+Opcode jumpOpcode(BinaryOperator op, bool whenTrue) {
+    switch (op) {
+        case BinaryOperator::Less: return whenTrue ? Opcode::JumpLess : Opcode::JumpGreaterEqual;
+        case BinaryOperator::LessEqual: return whenTrue ? Opcode::JumpLessEqual : Opcode::JumpGreater;
+        case BinaryOperator::Greater: return whenTrue ? Opcode::JumpGreater : Opcode::JumpLessEqual;
+        case BinaryOperator::GreaterEqual: return whenTrue ? Opcode::JumpGreaterEqual : Opcode::JumpLess;
+        case BinaryOperator::Equal: return whenTrue ? Opcode::JumpEqual : Opcode::JumpNotEqual;
+        default: return whenTrue ? Opcode::JumpNotEqual : Opcode::JumpEqual;
+    }
+}
+
+class BytecodeCompiler {
+public:
+    BytecodeCompiler(const SymbolTable& symbolTable, const std::vector<int32_t>& functionIndex)
+        : symbolTable(symbolTable), functionIndex(functionIndex) {}
+
+    BytecodeFunction compile(const ASTNode* function) {
+        const Symbol& symbol = symbolTable.getSymbol(function->symbol);
+        out = BytecodeFunction();
+        out.name = function->value;
+        out.arity = symbol.arity;
+        firstLocal = symbol.firstLocal;
+        localCount = symbol.localCount;
+
+        // literals get registers after the locals, loaded once per call instead of at every use in a loop
+        constants.clear();
+        collectConstants(function);
+        baseTemporary = localCount + static_cast<uint32_t>(constants.size());
+        nextTemporary = baseTemporary;
+        out.registerCount = baseTemporary;
+        for (const auto& [value, reg] : constants) {
+            emit(Opcode::LoadConst, reg, value);
+        }
+
+        // local arrays get their place in the frame's array area up front, the header holds the length
+        for (uint32_t i = 0; i < symbol.localCount; ++i) {
+            const Symbol& local = symbolTable.getSymbol(firstLocal + static_cast<int32_t>(i));
+            if (local.kind == SymbolKind::Parameter) {
+                if (i < symbol.arity) out.arrayParameters.push_back(local.type == ValueType::IntArray);
+                continue;
+            }
+            if (local.type != ValueType::IntArray) continue;
+            uint32_t elements = out.arrayWords + ARRAY_HEADER_WORDS;
+            emit(Opcode::ArrayAddress, static_cast<int32_t>(i), static_cast<int32_t>(elements),
+                 static_cast<int32_t>(local.length));
+            out.arrayWords = elements + (local.length + ARRAY_HEADER_WORDS - 1) / ARRAY_HEADER_WORDS * ARRAY_HEADER_WORDS;
+        }
+
+        compileStatements(function->children);
+        // falling off the end returns 0 like the generated code
+        int32_t zero = allocateTemporary();
+        emit(Opcode::LoadConst, zero, 0);
+        emit(Opcode::Return, zero);
+
+        if (out.registerCount > MAX_FRAME_REGISTERS) {
+            handleError("Function " + std::string(function->value) + " needs more registers than the interpreter has",
+                        function->span());
+        }
+        return std::move(out);
+    }
+
+private:
+    int32_t registerOf(int32_t symbol) const { return symbol - firstLocal; }
+
+    void collectConstants(const ASTNode* function) {
+        forEachNode(function, [&](const ASTNode* node) {
+            if (node->kind == NodeKind::Literal && constants.size() < MAX_CONSTANT_REGISTERS &&
+                !constants.count(node->number)) {
+                constants.emplace(node->number, static_cast<int32_t>(localCount + constants.size()));
+            }
+        });
+    }
+
+    int32_t allocateTemporary() {
+        int32_t reg = static_cast<int32_t>(nextTemporary++);
+        out.registerCount = std::max(out.registerCount, nextTemporary);
+        return reg;
+    }
+
+    size_t emit(Opcode op, int32_t a = 0, int32_t b = 0, int32_t c = 0) {
+        out.code.push_back({op, a, b, c});
+        return out.code.size() - 1;
+    }
+
+    int32_t here() const { return static_cast<int32_t>(out.code.size()); }
+
+    void patch(size_t jump, int32_t target) {
+        Instruction& instruction = out.code[jump];
+        switch (instruction.op) {
+            case Opcode::Jump: instruction.a = target; break;
+            case Opcode::JumpIfZero:
+            case Opcode::JumpIfNotZero: instruction.b = target; break;
+            default: instruction.c = target; break;
+        }
+    }
+
+    void compileStatements(NodeList statements) {
+        for (const ASTNode* statement : statements) {
+            // no temporary outlives a statement
+            nextTemporary = baseTemporary;
+            compileStatement(statement);
+        }
+    }
+
+    void compileStatement(const ASTNode* statement) {
+        switch (statement->kind) {
+        case NodeKind::VariableDeclaration: {
+            const ASTNode* initializer = statement->children[statement->children.size() - 1];
+            if (initializer->kind == NodeKind::Type) {
+                emit(Opcode::ZeroArray, registerOf(statement->symbol));
+            } else {
+                compileInto(initializer, registerOf(statement->symbol));
+            }
+            break;
+        }
+        case NodeKind::Assignment: {
+            const ASTNode* target = statement->children[0];
+            if (target->kind == NodeKind::Index) {
+                int32_t index = compileOperand(target->children[0]);
+                int32_t value = compileOperand(statement->children[1]);
+                emit(Opcode::StoreElement, registerOf(target->symbol), index, value);
+            } else {
+                compileInto(statement->children[1], registerOf(target->symbol));
+            }
+            break;
+        }
+        case NodeKind::ReturnStatement:
+            emit(Opcode::Return, compileOperand(statement->children[0]));
+            break;
+        case NodeKind::Call:
+            compileOperand(statement);
+            break;
+        case NodeKind::Block:
+            compileStatements(statement->children);
+            break;
+        case NodeKind::If: {
+            size_t skipThen = compileBranch(statement->children[0], false);
+            compileStatement(statement->children[1]);
+            if (statement->children.size() > 2) {
+                size_t skipElse = emit(Opcode::Jump);
+                patch(skipThen, here());
+                nextTemporary = baseTemporary;
+                compileStatement(statement->children[2]);
+                patch(skipElse, here());
+            } else {
+                patch(skipThen, here());
+            }
+            break;
+        }
+        case NodeKind::While:
+        case NodeKind::For: {
+            // the condition is tested at the bottom, an iteration takes one jump
+            bool isFor = statement->kind == NodeKind::For;
+            if (isFor) {
+                compileStatement(statement->children[0]);
+            }
+            size_t toCondition = emit(Opcode::Jump);
+            int32_t body = here();
+            compileStatement(statement->children[isFor ? 3 : 1]);
+            if (isFor) {
+                nextTemporary = baseTemporary;
+                compileStatement(statement->children[2]);
+            }
+            patch(toCondition, here());
+            nextTemporary = baseTemporary;
+            patch(compileBranch(statement->children[isFor ? 1 : 0], true), body);
+            break;
+        }
+        default:
+            break; // parameters arrive in their registers
+        }
+    }
+
+    /**
+     * @brief Function to emit a conditional jump, its target is patched by the caller
+     * @param whenTrue Jump if the condition holds, otherwise if it does not
+     * @return Index of the jump
+     */
+    size_t compileBranch(const ASTNode* condition, bool whenTrue) {
+        if (condition->kind == NodeKind::BinaryOp) {
+            BinaryOperator op = binaryOperator(condition->value);
+            if (isComparison(op)) {
+                int32_t lhs = compileOperand(condition->children[0]);
+                int32_t rhs = compileOperand(condition->children[1]);
+                return emit(jumpOpcode(op, whenTrue), lhs, rhs);
+            }
+        }
+        return emit(whenTrue ? Opcode::JumpIfNotZero : Opcode::JumpIfZero, compileOperand(condition));
+    }
+
+    /**
+     * @brief Function to get the register of a variable or of a literal's constant
+     * @return false if the value must be computed into a register
+     */
+    bool ownRegister(const ASTNode* node, int32_t& reg) const {
+        if (node->kind == NodeKind::Variable) {
+            reg = registerOf(node->symbol);
+            return true;
+        }
+        if (node->kind == NodeKind::Literal) {
+            auto constant = constants.find(node->number);
+            if (constant != constants.end()) {
+                reg = constant->second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Function to get a register holding the value of an expression; a variable's or
+     *        literal's own register, or a temporary the value is computed into
+     */
+    int32_t compileOperand(const ASTNode* node) {
+        int32_t reg;
+        if (ownRegister(node, reg)) {
+            return reg;
+        }
+        reg = allocateTemporary();
+        compileInto(node, reg);
+        return reg;
+    }
+
+    /**
+     * @brief Expression node being compiled into a register, waiting for its operands
+     */
+    struct PendingNode {
+        const ASTNode* node;
+        int32_t target;
+        uint32_t mark;          // first free temporary when the node was started, freed again once it is done
+        int32_t first = 0;      // register of the first argument of a call
+        uint32_t next = 0;      // next child to compile
+        int32_t operands[2] = {};
+    };
+
+    /**
+     * @brief Function to start compiling a node into a register; leaves are emitted at once,
+     *        other nodes are pushed to wait for their operands
+     */
+    void startInto(const ASTNode* node, int32_t target) {
+        switch (node->kind) {
+        case NodeKind::Literal:
+            emit(Opcode::LoadConst, target, node->number);
+            break;
+        case NodeKind::Variable:
+            if (registerOf(node->symbol) != target) {
+                emit(Opcode::Move, target, registerOf(node->symbol));
+            }
+            break;
+        case NodeKind::Call: {
+            // arguments go to consecutive registers, an array is passed as its address
+            PendingNode call{node, target, nextTemporary};
+            call.first = static_cast<int32_t>(nextTemporary);
+            for (size_t i = 0; i < node->children.size(); ++i) allocateTemporary();
+            pendingNodes.push_back(call);
+            break;
+        }
+        case NodeKind::Index:
+        case NodeKind::BinaryOp:
+            pendingNodes.push_back({node, target, nextTemporary});
+            break;
+        default:
+            handleError(std::string("Unhandled ASTNode type in bytecode: ") + nodeKindName(node->kind), node->span());
+        }
+    }
+
+    /**
+     * @brief Function to compute an expression into a register, which is only written once
+     *        every operand has been read so it may be one of them. Nodes wait for their
+     *        operands on an explicit stack, so expressions of any depth are safe to compile.
+     */
+    void compileInto(const ASTNode* expression, int32_t target) {
+        size_t base = pendingNodes.size();
+        startInto(expression, target);
+        while (pendingNodes.size() > base) {
+            PendingNode& pending = pendingNodes.back();
+            const ASTNode* node = pending.node;
+            if (pending.next < node->children.size()) {
+                uint32_t i = pending.next++;
+                const ASTNode* child = node->children[i];
+                if (node->kind == NodeKind::Call) {
+                    startInto(child, pending.first + static_cast<int32_t>(i));
+                    continue;
+                }
+                int32_t reg;
+                if (!ownRegister(child, reg)) {
+                    // a temporary target is read by this node alone, so one operand may be computed in it;
+                    // chains like a+b+c+... and a-(b-(c-...)) then take the same few registers at any length
+                    bool temporary = static_cast<uint32_t>(pending.target) >= baseTemporary;
+                    bool targetFree = i == 0 || pending.operands[0] != pending.target;
+                    reg = temporary && targetFree ? pending.target : allocateTemporary();
+                    pending.operands[i] = reg;
+                    startInto(child, reg);
+                    continue;
+                }
+                pending.operands[i] = reg;
+                continue;
+            }
+            if (node->kind == NodeKind::Index) {
+                emit(Opcode::LoadElement, pending.target, registerOf(node->symbol), pending.operands[0]);
+            } else if (node->kind == NodeKind::Call) {
+                emit(Opcode::Call, pending.target, functionIndex[node->symbol], pending.first);
+            } else {
+                emit(arithmeticOpcode(binaryOperator(node->value)), pending.target, pending.operands[0],
+                     pending.operands[1]);
+            }
+            nextTemporary = pending.mark;
+            pendingNodes.pop_back();
+        }
+    }
+
+    const SymbolTable& symbolTable;
+    const std::vector<int32_t>& functionIndex; // bytecode function index by symbol slot
+    BytecodeFunction out;
+    int32_t firstLocal = 0;
+    uint32_t localCount = 0;
+    uint32_t baseTemporary = 0; // first register after the locals and constants
+    uint32_t nextTemporary = 0;
+    std::map<int32_t, int32_t> constants; // register of each literal value, ordered so output is deterministic
+    std::vector<PendingNode> pendingNodes; // stack of compileInto, kept so its storage is reused
+};
+
+} // namespace
+
+BytecodeProgram compileBytecode(const ASTNode* program, const SymbolTable& symbolTable) {
+    BytecodeProgram result;
+    std::vector<int32_t> functionIndex(symbolTable.size(), -1);
+    for (size_t i = 0; i < program->children.size(); ++i) {
+        functionIndex[program->children[i]->symbol] = static_cast<int32_t>(i);
+        if (program->children[i]->value == "main") result.main = static_cast<int32_t>(i);
+    }
+
+    BytecodeCompiler compiler(symbolTable, functionIndex);
+    result.functions.reserve(program->children.size());
+    for (const ASTNode* function : program->children) {
+        result.functions.push_back(compiler.compile(function));
+    }
+    return result;
+}
+
+void printBytecode(const BytecodeProgram& program) {
+    for (const BytecodeFunction& function : program.functions) {
+        std::cout << "fn " << function.name << ": " << function.arity << " parameters, " << function.registerCount
+                  << " registers, " << function.arrayWords << " array words\n";
+        for (size_t i = 0; i < function.code.size(); ++i) {
+            const Instruction& instruction = function.code[i];
+            std::cout << std::setw(6) << i << "  " << std::left << std::setw(10) << opcodeName(instruction.op)
+                      << std::right << instruction.a << ", " << instruction.b << ", " << instruction.c << "\n";
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "../parser/parser.h"
+#include "../analysis/analysis.h"
+
+/**
+ * @brief Register machine instructions. Operands a, b and c are register numbers of the
+ *        current frame unless noted; conditional jumps jump to c when the comparison holds.
+ */
+enum class Opcode : uint8_t {
+    LoadConst,        // a = b (immediate)
+    Move,             // a = b
+    Add,              // a = b + c, wrapping
+    Subtract,         // a = b - c, wrapping
+    Multiply,         // a = b * c, wrapping
+    Divide,           // a = b / c, error on division by zero
+    Less,             // a = b < c
+    LessEqual,        // a = b <= c
+    Greater,          // a = b > c
+    GreaterEqual,     // a = b >= c
+    Equal,            // a = b == c
+    NotEqual,         // a = b != c
+    Jump,             // jump to a (instruction index)
+    JumpIfZero,       // jump to b if a == 0
+    JumpIfNotZero,    // jump to b if a != 0
+    JumpLess,         // jump to c if a < b
+    JumpLessEqual,    // jump to c if a <= b
+    JumpGreater,      // jump to c if a > b
+    JumpGreaterEqual, // jump to c if a >= b
+    JumpEqual,        // jump to c if a == b
+    JumpNotEqual,     // jump to c if a != b
+    ArrayAddress,     // a = address of the local array at word b of the frame's array area
+    ZeroArray,        // zero the array whose address is in a
+    LoadElement,      // a = element c of the array whose address is in b, error if out of bounds
+    StoreElement,     // element b of the array whose address is in a = c, error if out of bounds
+    Call,             // a = function b called with the arguments in registers c, c + 1, ...
+    Return            // return a
+};
+
+/**
+ * @brief Function to get the mnemonic of an opcode
+ */
+const char* opcodeName(Opcode op);
+
+struct Instruction {
+    Opcode op;
+    int32_t a = 0;
+    int32_t b = 0;
+    int32_t c = 0;
+};
+
+// every array in the interpreter's memory is preceded by a header holding its length,
+// padded so elements keep the alignment native code assumes
+constexpr uint32_t ARRAY_HEADER_WORDS = 4;
+
+struct BytecodeFunction {
+    std::string_view name;
+    uint32_t arity = 0;
+    std::vector<bool> arrayParameters; // per parameter, passed as an array address
+    uint32_t registerCount = 0;        // parameters and locals, then constants, then temporaries
+    uint32_t arrayWords = 0;           // memory the frame's local arrays and their headers take
+    std::vector<Instruction> code;
+};
+
+struct BytecodeProgram {
+    std::vector<BytecodeFunction> functions; // in program order
+    int32_t main = -1;                       // index of main, -1 if the program has none
+};
+
+/**
+ * @brief Function to compile a resolved and folded program to bytecode. Every parameter
+ *        and local gets the register of its symbol slot, followed by registers the function's
+ *        literals are loaded into on entry; expressions use temporaries above them that are
+ *        released once the statement is done.
+ * @param program Program node, resolved by semanticAnalysis
+ * @param symbolTable Table the program was resolved against
+ * @return Program
+ * @throws CompileError if a function needs more registers than a frame holds
+ */
+BytecodeProgram compileBytecode(const ASTNode* program, const SymbolTable& symbolTable);
+
+/**
+ * @brief Function to print the bytecode of a program, one instruction per line
+ */
+void printBytecode(const BytecodeProgram& program);
+
+#endif // BYTECODE_H
@@ -0,0 +1,230 @@
+#include "interpreter.h"
+#include "../jit/runtime.h"
+#include "../logger/logger.h"
+#include <algorithm>
+#include <cstring>
+
+// 16 MB of registers and 64 MB of arrays, reserved up front but only committed when touched
+static constexpr size_t REGISTER_STACK_WORDS = size_t(1) << 22;
+static constexpr size_t MEMORY_WORDS = size_t(1) << 24;
+
+Interpreter::Interpreter(const BytecodeProgram& program, NativeTier* tier, uint32_t tierUpCalls)
+    : program(program),
+      tier(tier),
+      tierUpCalls(tierUpCalls),
+      registers(new int32_t[REGISTER_STACK_WORDS]),
+      memory(new int32_t[MEMORY_WORDS]),
+      calls(program.functions.size(), 0),
+      native(program.functions.size(), nullptr) {}
+
+static inline int32_t wrap(uint32_t value) {
+    return static_cast<int32_t>(value);
+}
+
+bool Interpreter::run(int32_t& result) {
+    if (program.main < 0) {
+        log::error("Program has no main function");
+        return false;
+    }
+
+    // one label per Opcode, in declaration order
+    static void* const dispatch[] = {
+        &&LoadConst, &&Move, &&Add, &&Subtract, &&Multiply, &&Divide,
+        &&Less, &&LessEqual, &&Greater, &&GreaterEqual, &&Equal, &&NotEqual,
+        &&Jump, &&JumpIfZero, &&JumpIfNotZero,
+        &&JumpLess, &&JumpLessEqual, &&JumpGreater, &&JumpGreaterEqual, &&JumpEqual, &&JumpNotEqual,
+        &&ArrayAddress, &&ZeroArray, &&LoadElement, &&StoreElement, &&Call, &&Return,
+    };
+    static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == static_cast<size_t>(Opcode::Return) + 1,
+                  "every opcode needs a label");
+
+    const BytecodeFunction* function = &program.functions[program.main];
+    const Instruction* code = function->code.data();
+    const Instruction* pc = code;
+    int32_t* r = registers.get();
+    int32_t* const registersEnd = registers.get() + REGISTER_STACK_WORDS;
+    int32_t* const words = memory.get();
+    uint32_t memoryTop = 0;
+    const char* error = nullptr;
+    frames.clear();
+
+    if (function->registerCount > REGISTER_STACK_WORDS || function->arrayWords > MEMORY_WORDS) {
+        error = "stack overflow";
+        goto Fail;
+    }
+
+#define DISPATCH() goto *dispatch[static_cast<uint8_t>(pc->op)]
+#define NEXT() do { ++pc; DISPATCH(); } while (0)
+#define JUMP_IF(condition, target) do { pc = (condition) ? code + (target) : pc + 1; DISPATCH(); } while (0)
+
+    DISPATCH();
+
+LoadConst:
+    r[pc->a] = pc->b;
+    NEXT();
+Move:
+    r[pc->a] = r[pc->b];
+    NEXT();
+Add:
+    r[pc->a] = wrap(static_cast<uint32_t>(r[pc->b]) + static_cast<uint32_t>(r[pc->c]));
+    NEXT();
+Subtract:
+    r[pc->a] = wrap(static_cast<uint32_t>(r[pc->b]) - static_cast<uint32_t>(r[pc->c]));
+    NEXT();
+Multiply:
+    r[pc->a] = wrap(static_cast<uint32_t>(r[pc->b]) * static_cast<uint32_t>(r[pc->c]));
+    NEXT();
+Divide: {
+    int32_t divisor = r[pc->c];
+    if (divisor == 0) {
+        error = runtimeErrorMessage(RuntimeError::DivisionByZero);
+        goto Fail;
+    }
+    // INT_MIN / -1 wraps instead of trapping
+    r[pc->a] = divisor == -1 ? wrap(0u - static_cast<uint32_t>(r[pc->b])) : r[pc->b] / divisor;
+    NEXT();
+}
+Less:
+    r[pc->a] = r[pc->b] < r[pc->c];
+    NEXT();
+LessEqual:
+    r[pc->a] = r[pc->b] <= r[pc->c];
+    NEXT();
+Greater:
+    r[pc->a] = r[pc->b] > r[pc->c];
+    NEXT();
+GreaterEqual:
+    r[pc->a] = r[pc->b] >= r[pc->c];
+    NEXT();
+Equal:
+    r[pc->a] = r[pc->b] == r[pc->c];
+    NEXT();
+NotEqual:
+    r[pc->a] = r[pc->b] != r[pc->c];
+    NEXT();
+Jump:
+    pc = code + pc->a;
+    DISPATCH();
+JumpIfZero:
+    JUMP_IF(r[pc->a] == 0, pc->b);
+JumpIfNotZero:
+    JUMP_IF(r[pc->a] != 0, pc->b);
+JumpLess:
+    JUMP_IF(r[pc->a] < r[pc->b], pc->c);
+JumpLessEqual:
+    JUMP_IF(r[pc->a] <= r[pc->b], pc->c);
+JumpGreater:
+    JUMP_IF(r[pc->a] > r[pc->b], pc->c);
+JumpGreaterEqual:
+    JUMP_IF(r[pc->a] >= r[pc->b], pc->c);
+JumpEqual:
+    JUMP_IF(r[pc->a] == r[pc->b], pc->c);
+JumpNotEqual:
+    JUMP_IF(r[pc->a] != r[pc->b], pc->c);
+ArrayAddress: {
+    int32_t address = static_cast<int32_t>(memoryTop) + pc->b;
+    words[address - 1] = pc->c;
+    r[pc->a] = address;
+    NEXT();
+}
+ZeroArray: {
+    int32_t address = r[pc->a];
+    std::memset(words + address, 0, sizeof(int32_t) * static_cast<uint32_t>(words[address - 1]));
+    NEXT();
+}
+LoadElement: {
+    int32_t address = r[pc->b];
+    uint32_t index = static_cast<uint32_t>(r[pc->c]);
+    if (index >= static_cast<uint32_t>(words[address - 1])) {
+        error = runtimeErrorMessage(RuntimeError::IndexOutOfBounds);
+        goto Fail;
+    }
+    r[pc->a] = words[address + index];
+    NEXT();
+}
+StoreElement: {
+    int32_t address = r[pc->a];
+    uint32_t index = static_cast<uint32_t>(r[pc->b]);
+    if (index >= static_cast<uint32_t>(words[address - 1])) {
+        error = runtimeErrorMessage(RuntimeError::IndexOutOfBounds);
+        goto Fail;
+    }
+    words[address + index] = r[pc->c];
+    NEXT();
+}
+Call: {
+    size_t callee = static_cast<size_t>(pc->b);
+    const BytecodeFunction& target = program.functions[callee];
+    if (!native[callee] && tier && ++calls[callee] >= tierUpCalls) {
+        // the first call past the threshold starts the compile, later ones check whether it is done
+        if (calls[callee] == tierUpCalls) {
+            tier->request();
+        } else if (tier->ready()) {
+            native[callee] = tier->entry(callee);
+            ++tieredUp;
+            log::debug("Tiered up {} after {} calls", target.name, calls[callee]);
+        }
+    }
+    if (native[callee]) {
+        nativeArguments.resize(target.arity);
+        for (uint32_t i = 0; i < target.arity; ++i) {
+            int32_t argument = r[pc->c + static_cast<int32_t>(i)];
+            nativeArguments[i] = target.arrayParameters[i] ? reinterpret_cast<intptr_t>(words + argument) : argument;
+        }
+        // native code stops at the same runtime errors as the interpreter, reported the same way
+        NativeTier::Entry entry = native[callee];
+        const int64_t* arguments = nativeArguments.data();
+        int32_t value = 0;
+        RuntimeError failure = runChecked([&] { value = entry(arguments); });
+        if (failure != RuntimeError::None) {
+            function = &target;
+            error = runtimeErrorMessage(failure);
+            goto Fail;
+        }
+        r[pc->a] = value;
+        NEXT();
+    }
+
+    int32_t* calleeRegisters = r + function->registerCount;
+    uint32_t calleeMemory = memoryTop + function->arrayWords;
+    if (target.registerCount > static_cast<size_t>(registersEnd - calleeRegisters) ||
+        target.arrayWords > MEMORY_WORDS - calleeMemory) {
+        error = "stack overflow";
+        goto Fail;
+    }
+    frames.push_back({function, pc, r, memoryTop});
+    for (uint32_t i = 0; i < target.arity; ++i) {
+        calleeRegisters[i] = r[pc->c + static_cast<int32_t>(i)];
+    }
+    function = &target;
+    code = target.code.data();
+    pc = code;
+    r = calleeRegisters;
+    memoryTop = calleeMemory;
+    DISPATCH();
+}
+Return: {
+    int32_t value = r[pc->a];
+    if (frames.empty()) {
+        result = value;
+        return true;
+    }
+    const Frame& caller = frames.back();
+    function = caller.function;
+    code = function->code.data();
+    pc = caller.call;
+    r = caller.registers;
+    memoryTop = caller.memoryTop;
+    frames.pop_back();
+    r[pc->a] = value;
+    NEXT();
+}
+
+#undef DISPATCH
+#undef NEXT
+#undef JUMP_IF
+
+Fail:
+    log::error("Runtime error in {}: {}", function->name, error);
+    return false;
+}
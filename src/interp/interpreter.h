@@ -0,0 +1,61 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "bytecode.h"
+#include "native_tier.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Interpreter for BytecodeProgram, dispatching with computed gotos. Frames live on
+ *        a register stack and arrays in a word memory, both allocated once and committed by
+ *        the OS as they are touched. Division by zero, an index out of bounds and running out
+ *        of stack stop the program with an error instead of being undefined.
+ *
+ *        With a NativeTier, a function called tierUpCalls times asks for native code and once
+ *        it is ready further calls to it run natively. A frame already being interpreted stays
+ *        in the interpreter, main therefore never leaves it.
+ */
+class Interpreter {
+public:
+    /**
+     * @param program Program to run, must outlive the interpreter
+     * @param tier Native code to tier up to, null to interpret only
+     * @param tierUpCalls Calls of a function before it tiers up
+     */
+    Interpreter(const BytecodeProgram& program, NativeTier* tier, uint32_t tierUpCalls);
+
+    /**
+     * @brief Function to run main
+     * @param result Return value of main
+     * @return false on a runtime error, which is logged
+     */
+    bool run(int32_t& result);
+
+    /**
+     * @brief Function to get the number of functions that tiered up to native code
+     */
+    size_t tieredUpCount() const { return tieredUp; }
+
+private:
+    struct Frame {
+        const BytecodeFunction* function;
+        const Instruction* call;  // instruction the frame continues after
+        int32_t* registers;
+        uint32_t memoryTop;       // start of the frame's array area
+    };
+
+    const BytecodeProgram& program;
+    NativeTier* tier;
+    uint32_t tierUpCalls;
+    std::unique_ptr<int32_t[]> registers;
+    std::unique_ptr<int32_t[]> memory;
+    std::vector<Frame> frames;
+    std::vector<uint32_t> calls;                 // per function
+    std::vector<NativeTier::Entry> native;       // per function, set once it tiered up
+    std::vector<int64_t> nativeArguments;
+    size_t tieredUp = 0;
+};
+
+#endif // INTERPRETER_H
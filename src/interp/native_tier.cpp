@@ -0,0 +1,117 @@
+#include "native_tier.h"
+#include "../llvm/llvm_generator.h"
+#include "../target/target.h"
+#include "../logger/logger.h"
+#include "../timing/time_report.h"
+#include "../jit/runtime.h"
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/Verifier.h>
+#include <chrono>
+#include <exception>
+
+NativeTier::NativeTier(ASTNode* program, const SymbolTable& symbolTable, OptLevel level)
+    : program(program), symbolTable(symbolTable), level(level) {}
+
+NativeTier::~NativeTier() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void NativeTier::request() {
+    State idle = State::Idle;
+    if (state.compare_exchange_strong(idle, State::Compiling)) {
+        // compiled inside the interpreter's phase, which outlives the tier
+        worker = std::thread([this, phase = TimeReport::Scope::current()] {
+            TimeReport::Worker measured(phase);
+            compile();
+        });
+    }
+}
+
+/**
+ * @brief Function to add an entry taking the arguments as an array of int64, i32 (i64*)
+ */
+static void addEntry(llvm::Function& function, llvm::Module& module) {
+    llvm::LLVMContext& context = module.getContext();
+    llvm::IRBuilder<> builder(context);
+    llvm::FunctionType* type =
+        llvm::FunctionType::get(builder.getInt32Ty(), {builder.getInt64Ty()->getPointerTo()}, false);
+    llvm::Function* entry = llvm::Function::Create(type, llvm::Function::ExternalLinkage,
+                                                   "nv.entry." + function.getName(), &module);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", entry));
+
+    std::vector<llvm::Value*> arguments;
+    for (llvm::Argument& parameter : function.args()) {
+        llvm::Value* slot = builder.CreateConstInBoundsGEP1_64(builder.getInt64Ty(), entry->getArg(0), parameter.getArgNo());
+        llvm::Value* value = builder.CreateLoad(builder.getInt64Ty(), slot);
+        arguments.push_back(parameter.getType()->isPointerTy() ? builder.CreateIntToPtr(value, parameter.getType())
+                                                               : builder.CreateTrunc(value, parameter.getType()));
+    }
+    builder.CreateRet(builder.CreateCall(&function, arguments));
+}
+
+void NativeTier::compile() {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        CodeGenerator generator;
+        generator.generate(program, symbolTable);
+        std::unique_ptr<llvm::LLVMContext> context = generator.takeContext();
+        std::unique_ptr<llvm::Module> module = generator.takeModule();
+
+        std::vector<std::string> names;
+        for (const ASTNode* function : program->children) {
+            llvm::Function* defined = module->getFunction(llvm::StringRef(function->value.data(), function->value.size()));
+            if (!defined) throw std::runtime_error("missing function " + std::string(function->value));
+            addEntry(*defined, *module);
+            names.push_back("nv.entry." + std::string(function->value));
+        }
+        if (llvm::verifyModule(*module, &llvm::errs())) {
+            throw std::runtime_error("module verification failed");
+        }
+
+        initializeNativeTarget();
+        std::unique_ptr<llvm::TargetMachine> targetMachine = createHostTargetMachine(level);
+        if (targetMachine) {
+            configureModuleForTarget(*module, *targetMachine);
+        }
+        optimizeModule(*module, level, targetMachine.get(), false);
+
+        auto created = llvm::orc::LLJITBuilder().create();
+        if (!created) {
+            throw std::runtime_error(llvm::toString(created.takeError()));
+        }
+        jit = std::move(*created);
+        // arrays are zeroed with memset from the host process; runtime errors go to the host's handler
+        auto process = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix());
+        if (!process) {
+            throw std::runtime_error(llvm::toString(process.takeError()));
+        }
+        jit->getMainJITDylib().addGenerator(std::move(*process));
+        if (auto error = defineRuntime(*jit, jit->getMainJITDylib())) {
+            throw std::runtime_error(llvm::toString(std::move(error)));
+        }
+        if (auto error = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+            throw std::runtime_error(llvm::toString(std::move(error)));
+        }
+
+        std::vector<Entry> resolved;
+        for (const std::string& name : names) {
+            auto symbol = jit->lookup(name);
+            if (!symbol) {
+                throw std::runtime_error(llvm::toString(symbol.takeError()));
+            }
+            resolved.push_back(reinterpret_cast<Entry>(symbol->getAddress()));
+        }
+        entries = std::move(resolved);
+    } catch (const std::exception& error) {
+        // the interpreter keeps running the program, only slower
+        log::warn("Native tier unavailable: {}", error.what());
+        state.store(State::Failed, std::memory_order_release);
+        return;
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    log::debug("Native tier compiled {} functions in {} ms", entries.size(), elapsed);
+    state.store(State::Ready, std::memory_order_release);
+}
@@ -0,0 +1,69 @@
+#ifndef NATIVE_TIER_H
+#define NATIVE_TIER_H
+
+#include "../parser/parser.h"
+#include "../analysis/analysis.h"
+#include "../optimizer/optimizer.h"
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Native code for a program, JIT-compiled on a background thread once the interpreter
+ *        asks for it so interpretation goes on while LLVM works. Every function gets an entry
+ *        that takes its arguments as an array, ints sign extended and arrays as addresses,
+ *        so the interpreter can call any signature the same way.
+ */
+class NativeTier {
+public:
+    using Entry = int32_t (*)(const int64_t* arguments);
+
+    /**
+     * @param program Program node, resolved and folded; must stay alive and unchanged while the tier exists
+     * @param symbolTable Table the program was resolved against
+     * @param level Optimization level of the native code
+     */
+    NativeTier(ASTNode* program, const SymbolTable& symbolTable, OptLevel level);
+
+    /**
+     * @brief Waits for a compile in progress, the JIT owns the code the entries point to
+     */
+    ~NativeTier();
+
+    NativeTier(const NativeTier&) = delete;
+    NativeTier& operator=(const NativeTier&) = delete;
+
+    /**
+     * @brief Function to start compiling the program, later calls do nothing
+     */
+    void request();
+
+    /**
+     * @brief Function to check whether the native code is ready to be called
+     */
+    bool ready() const { return state.load(std::memory_order_acquire) == State::Ready; }
+
+    /**
+     * @brief Function to get the entry of a function, only once ready()
+     * @param function Index of the function in the program
+     */
+    Entry entry(size_t function) const { return entries[function]; }
+
+private:
+    enum class State { Idle, Compiling, Ready, Failed };
+
+    void compile();
+
+    ASTNode* program;
+    const SymbolTable& symbolTable;
+    OptLevel level;
+    std::atomic<State> state{State::Idle};
+    std::thread worker;
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    std::vector<Entry> entries; // written by the worker before state becomes Ready
+};
+
+#endif // NATIVE_TIER_H
@@ -0,0 +1,58 @@
+#include "jit.h"
+#include "runtime.h"
+#include "../logger/logger.h"
+#include "../target/target.h"
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool runJIT(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context,
+            std::chrono::steady_clock::time_point startTime, int& result) {
+    initializeNativeTarget();
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+        log::error("Failed to create JIT: {}", llvm::toString(jit.takeError()));
+        return false;
+    }
+
+    // arrays are zeroed with memset, which comes from the host process
+    auto process = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+    if (!process) {
+        log::error("Failed to search the process for symbols: {}", llvm::toString(process.takeError()));
+        return false;
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*process));
+    if (auto err = defineRuntime(**jit, (*jit)->getMainJITDylib())) {
+        log::error("Failed to bind the runtime to the JIT: {}", llvm::toString(std::move(err)));
+        return false;
+    }
+
+    llvm::orc::ThreadSafeModule threadSafeModule(std::move(module), std::move(context));
+    if (auto err = (*jit)->addIRModule(std::move(threadSafeModule))) {
+        log::error("Failed to add module to JIT: {}", llvm::toString(std::move(err)));
+        return false;
+    }
+
+    auto mainSymbol = (*jit)->lookup("main");
+    if (!mainSymbol) {
+        log::error("Failed to find main: {}", llvm::toString(mainSymbol.takeError()));
+        return false;
+    }
+
+    auto mainFunction = reinterpret_cast<int (*)()>(mainSymbol->getAddress());
+    double compiled = millisecondsSince(startTime);
+    RuntimeError error = runChecked([&] { result = mainFunction(); });
+    double finished = millisecondsSince(startTime);
+    if (error != RuntimeError::None) {
+        log::error("Runtime error: {}", runtimeErrorMessage(error));
+        return false;
+    }
+
+    log::info("JIT: main returned {}, {} ms to native code, {} ms startup to first result", result, compiled, finished);
+    return true;
+}
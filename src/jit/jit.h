@@ -0,0 +1,21 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <chrono>
+#include <memory>
+
+/**
+ * @brief Function to JIT-compile a module and call its main function in-process
+ * @param module Module to execute, ownership moves to the JIT
+ * @param context Context the module was created in
+ * @param startTime Point in time the compiler started, used for the startup report
+ * @param result Return value of main
+ * @return false if the module could not be compiled, has no main or main stopped with a
+ *         runtime error, which is logged
+ */
+bool runJIT(std::unique_ptr<llvm::Module> module, std::unique_ptr<llvm::LLVMContext> context,
+            std::chrono::steady_clock::time_point startTime, int& result);
+
+#endif // JIT_H
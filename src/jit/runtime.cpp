@@ -0,0 +1,59 @@
+#include "runtime.h"
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+
+// call of generated code running on this thread, and the error it stopped with
+static thread_local std::jmp_buf* activeCall = nullptr;
+static thread_local RuntimeError raised = RuntimeError::None;
+
+bool isRuntimeName(std::string_view name) {
+    // write and exit report errors in executables, the mem* functions back llvm.memset and loop idioms
+    for (std::string_view reserved : {std::string_view(RUNTIME_ERROR_HANDLER), std::string_view("write"),
+                                      std::string_view("exit"), std::string_view("memset"), std::string_view("memcpy"),
+                                      std::string_view("memmove")}) {
+        if (name == reserved) return true;
+    }
+    return false;
+}
+
+const char* runtimeErrorMessage(RuntimeError error) {
+    switch (error) {
+        case RuntimeError::None: return "no error";
+        case RuntimeError::DivisionByZero: return "division by zero";
+        case RuntimeError::IndexOutOfBounds: return "array index out of bounds";
+    }
+    return "unknown error";
+}
+
+/**
+ * @brief Handler generated code calls on a runtime error, leaves the generated frames for runChecked
+ */
+[[noreturn]] static void raiseRuntimeError(int32_t error) {
+    if (!activeCall) {
+        // called through a bare function pointer, there is no caller to hand the error to
+        std::fprintf(stderr, "Runtime error: %s\n", runtimeErrorMessage(static_cast<RuntimeError>(error)));
+        std::abort();
+    }
+    raised = static_cast<RuntimeError>(error);
+    std::longjmp(*activeCall, 1);
+}
+
+llvm::Error defineRuntime(llvm::orc::LLJIT& jit, llvm::orc::JITDylib& library) {
+    llvm::JITEvaluatedSymbol handler(llvm::pointerToJITTargetAddress(&raiseRuntimeError),
+                                     llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    return library.define(llvm::orc::absoluteSymbols({{jit.mangleAndIntern(RUNTIME_ERROR_HANDLER), handler}}));
+}
+
+RuntimeError runChecked(void (*call)(void*), void* context) {
+    std::jmp_buf trap;
+    std::jmp_buf* outer = activeCall; // not changed after setjmp, still valid once longjmp returns here
+    activeCall = &trap;
+    raised = RuntimeError::None;
+    if (setjmp(trap) == 0) {
+        call(context);
+    }
+    activeCall = outer;
+    return raised;
+}
@@ -0,0 +1,69 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <cstdint>
+#include <string_view>
+#include <llvm/Support/Error.h>
+
+namespace llvm {
+namespace orc {
+class LLJIT;
+class JITDylib;
+} // namespace orc
+} // namespace llvm
+
+/**
+ * Runtime errors of generated code. An index out of bounds or a division by zero branches to a
+ * call of RUNTIME_ERROR_HANDLER, which never returns. Every module carries a weak definition
+ * of the handler that prints the error and exits, used by objects and executables; code run
+ * in-process binds the handler to the host's instead, which ends the call that failed with
+ * the error, see runChecked.
+ */
+
+enum class RuntimeError : int32_t {
+    None,
+    DivisionByZero,
+    IndexOutOfBounds,
+};
+
+constexpr int32_t RUNTIME_ERROR_KINDS = static_cast<int32_t>(RuntimeError::IndexOutOfBounds) + 1;
+
+constexpr const char* RUNTIME_ERROR_HANDLER = "nova_runtime_error";
+
+/**
+ * @brief Function to check whether a function name belongs to the runtime: the error handler
+ *        or a C library function generated code calls, directly or through an LLVM intrinsic.
+ *        A program defining one would replace it in executables and the JIT.
+ */
+bool isRuntimeName(std::string_view name);
+
+/**
+ * @brief Function to describe a runtime error, as the interpreter reports it
+ */
+const char* runtimeErrorMessage(RuntimeError error);
+
+/**
+ * @brief Function to bind the runtime error handler of code added to a library to the host's,
+ *        before the code is added so its weak definition is dropped
+ * @return Error if the library defines the handler already
+ */
+llvm::Error defineRuntime(llvm::orc::LLJIT& jit, llvm::orc::JITDylib& library);
+
+/**
+ * @brief Function to run a call of generated code bound by defineRuntime, on this thread
+ * @param call Called once; frames between it and the generated code must hold nothing that
+ *        needs destroying, a runtime error leaves them without returning
+ * @param context Passed to call
+ * @return Error the generated code stopped with, RuntimeError::None if it returned
+ */
+RuntimeError runChecked(void (*call)(void*), void* context);
+
+/**
+ * @brief Function to run a callable under runChecked, e.g. runChecked([&] { result = main(); })
+ */
+template <typename Call>
+RuntimeError runChecked(Call call) {
+    return runChecked([](void* context) { (*static_cast<Call*>(context))(); }, &call);
+}
+
+#endif // RUNTIME_H
@@ -1,153 +1,599 @@
 #include "llvm_generator.h"
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Verifier.h>
 #include <fstream>
-#include "llvm_generator.h"
 #include "../logger/logger.h"
-#include <map>
+#include "../jit/runtime.h"
+#include <array>
+#include <vector>
+
+/**
+ * @brief Storage of the parameters and locals of the function being generated
+ */
+struct FunctionSlots {
+    const SymbolTable* symbolTable = nullptr; // types and array lengths of the slots
+    llvm::Function* function = nullptr;
+    int32_t firstLocal = 0;            // symbol slot of the first parameter or local
+    std::vector<llvm::Value*> values;  // indexed by symbol slot - firstLocal
+    uint32_t blockNodes = 0;           // expression nodes generated since the block was last split
+    // block calling the runtime error handler, per RuntimeError, shared by the checks of the function
+    std::array<llvm::BasicBlock*, RUNTIME_ERROR_KINDS> errorBlocks{};
+
+    llvm::Value*& operator[](int32_t symbol) { return values[symbol - firstLocal]; }
+    bool contains(int32_t symbol) const {
+        return symbol >= firstLocal && static_cast<size_t>(symbol - firstLocal) < values.size();
+    }
+};
 
-llvm::LLVMContext context;
-llvm::IRBuilder<> builder(context);
-llvm::Module* module = nullptr;
+llvm::Value* generateExpression(ASTNode* ast, CodeGenerator& cg, FunctionSlots& slots);
+static void generateStatement(ASTNode* statement, CodeGenerator& cg, FunctionSlots& slots);
+static void generateStatements(NodeList statements, CodeGenerator& cg, FunctionSlots& slots);
 
+CodeGenerator::CodeGenerator() {
+    reset();
+}
 
-llvm::Value* generateExpression(ASTNode* ast, std::map<std::string, llvm::Value*> &variableMap);
+void CodeGenerator::reset() {
+    if (!llvmContext) {
+        log::debug("Initializing LLVM");
+        llvmContext = std::make_unique<llvm::LLVMContext>();
+        irBuilder = std::make_unique<llvm::IRBuilder<>>(*llvmContext);
+    }
+    irBuilder->ClearInsertionPoint();
+    llvmModule = std::make_unique<llvm::Module>("cts_module", *llvmContext);
+}
+
+std::unique_ptr<llvm::Module> CodeGenerator::takeModule() {
+    return std::move(llvmModule);
+}
 
-void initializeLLVM() {
-    log::debug("Initializing LLVM");
-    module = new llvm::Module("cts_module", context);
+std::unique_ptr<llvm::LLVMContext> CodeGenerator::takeContext() {
+    // the builder refers to the context, drop it before handing the context away
+    irBuilder.reset();
+    return std::move(llvmContext);
 }
 
-void generateLLVMIR(ASTNode* ast) {
+static void generateNode(ASTNode* ast, CodeGenerator& cg, const SymbolTable& symbolTable);
+
+void CodeGenerator::generate(ASTNode* ast, const SymbolTable& symbolTable) {
+    generateNode(ast, *this, symbolTable);
+}
+
+// arrays are aligned for the widest vector loads the vectorizers emit on common targets
+static constexpr uint64_t ARRAY_ALIGNMENT = 16;
+
+// LLVM's fast register allocator, used at -O0, takes time quadratic in the length of a block,
+// so code is split over blocks of about this many expression nodes; -O1 and up merge them again
+static constexpr uint32_t BLOCK_EXPRESSION_NODES = 4096;
+
+static llvm::ArrayType* arrayType(uint32_t length, CodeGenerator& cg) {
+    return llvm::ArrayType::get(cg.builder().getInt32Ty(), length);
+}
+
+/**
+ * @brief Function to declare a function with its signature, int parameters are i32 and
+ *        int[N] parameters are pointers to [N x i32]
+ */
+static llvm::Function* declareFunction(int32_t slot, const SymbolTable& symbolTable, CodeGenerator& cg) {
+    std::string_view name = symbolTable.nameOf(slot);
+    if (llvm::Function* existing = cg.module().getFunction(llvm::StringRef(name.data(), name.size()))) {
+        return existing;
+    }
+    const Symbol& symbol = symbolTable.getSymbol(slot);
+    std::vector<llvm::Type*> parameters;
+    for (uint32_t i = 0; i < symbol.arity; ++i) {
+        uint32_t length = symbolTable.parameterLength(slot, i);
+        parameters.push_back(length ? static_cast<llvm::Type*>(arrayType(length, cg)->getPointerTo())
+                                    : cg.builder().getInt32Ty());
+    }
+    llvm::FunctionType* funcType = llvm::FunctionType::get(cg.builder().getInt32Ty(), parameters, false);
+    llvm::Function* function =
+        llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, name, &cg.module());
+    function->addFnAttr(llvm::Attribute::NoUnwind);
+
+    // semantic analysis rejects passing an array twice and a program has no other way to
+    // reach an array, so arrays never alias and loops over them vectorize without runtime checks
+    for (uint32_t i = 0; i < symbol.arity; ++i) {
+        uint32_t length = symbolTable.parameterLength(slot, i);
+        if (length == 0) continue;
+        function->addParamAttr(i, llvm::Attribute::NoAlias);
+        function->addParamAttr(i, llvm::Attribute::NoCapture);
+        function->addParamAttr(i, llvm::Attribute::NonNull);
+        function->addDereferenceableParamAttr(i, uint64_t(length) * sizeof(int32_t));
+        function->addParamAttr(i, llvm::Attribute::getWithAlignment(cg.context(), llvm::Align(ARRAY_ALIGNMENT)));
+    }
+    return function;
+}
+
+static void generateNode(ASTNode* ast, CodeGenerator& cg, const SymbolTable& symbolTable) {
     if (!ast) {
         log::error("AST is null");
         return;
     }
 
-    log::debug("Generating LLVM IR for node type: " + ast->type);
+    log::debug("Generating LLVM IR for node type: {}", nodeKindName(ast->kind));
+    llvm::IRBuilder<>& builder = cg.builder();
 
-    if (ast->type == "Function") {
-        log::debug("Defining function: " + ast->value);
+    if (ast->kind == NodeKind::Program) {
+        for (auto* function : ast->children) {
+            generateNode(function, cg, symbolTable);
+        }
+    } else if (ast->kind == NodeKind::Function) {
+        log::debug("Defining function: {}", ast->value);
 
-        llvm::FunctionType* funcType = llvm::FunctionType::get(builder.getInt32Ty(), false);
-        llvm::Function* function = llvm::Function::Create(
-            funcType, llvm::Function::ExternalLinkage, ast->value, module);
+        const Symbol& symbol = symbolTable.getSymbol(ast->symbol);
+        llvm::Function* function = declareFunction(ast->symbol, symbolTable, cg);
+        if (!function->empty()) {
+            handleError("Function defined twice: " + std::string(ast->value));
+        }
 
-        llvm::BasicBlock* block = llvm::BasicBlock::Create(context, "entry", function);
+        llvm::BasicBlock* block = llvm::BasicBlock::Create(cg.context(), "entry", function);
         builder.SetInsertPoint(block);
 
-        std::map<std::string, llvm::Value*> variableMap;
-
-        for (auto* child : ast->children) {
-            if (!child) {
-                handleError("ASTNode child is null in generateLLVMIR");
+        // storage of every parameter and local, indexed by the slot semantic analysis assigned
+        FunctionSlots slots;
+        slots.symbolTable = &symbolTable;
+        slots.function = function;
+        slots.firstLocal = symbol.firstLocal;
+        slots.values.assign(symbol.localCount, nullptr);
+
+        // every stack slot is allocated up front in the entry block, including those of locals
+        // declared in loops, so SROA and mem2reg promote them and loop bodies allocate nothing
+        for (uint32_t i = 0; i < symbol.localCount; ++i) {
+            int32_t slot = symbol.firstLocal + static_cast<int32_t>(i);
+            const Symbol& local = symbolTable.getSymbol(slot);
+            if (local.kind == SymbolKind::Parameter && local.type == ValueType::IntArray) {
+                continue; // passed by reference, the argument is the array
             }
-
-            if (child->type == "VariableDeclaration") {
-                std::string varName = child->value;
-                log::debug("Processing VariableDeclaration: " + varName);
-
-                if (child->children.size() < 2 || !child->children[1]) {
-                    handleError("Invalid initialization for variable: " + varName);
-                }
-
-                llvm::Value* initValue = generateExpression(child->children[1], variableMap);
-                if (!initValue) {
-                    handleError("Failed to generate initialization value for: " + varName);
-                }
-
-                llvm::AllocaInst* alloca = builder.CreateAlloca(builder.getInt32Ty(), nullptr, varName);
-                builder.CreateStore(initValue, alloca);
-                variableMap[varName] = alloca;  // Add the variable to the map
-                log::debug("Declared variable: " + varName + " with type int");
+            std::string_view name = symbolTable.nameOf(slot);
+            if (local.type == ValueType::IntArray) {
+                llvm::AllocaInst* alloca = builder.CreateAlloca(arrayType(local.length, cg), nullptr, name);
+                alloca->setAlignment(llvm::Align(ARRAY_ALIGNMENT));
+                slots[slot] = alloca;
+            } else {
+                slots[slot] = builder.CreateAlloca(builder.getInt32Ty(), nullptr, name);
             }
-            else if (child->type == "ReturnStatement") {
-                if (child->children.empty() || !child->children[0]) {
-                    handleError("Return statement has no value");
-                }
-
-                llvm::Value* retValue = generateExpression(child->children[0], variableMap);
-                if (!retValue) {
-                    log::error("Failed to generate return value");
-                    return;
-                }
-                builder.CreateRet(retValue);
-                log::debug("Added return value");
+        }
+
+        // parameters are the leading children
+        for (uint32_t i = 0; i < symbol.arity; ++i) {
+            ASTNode* parameter = ast->children[i];
+            llvm::Argument* argument = function->getArg(i);
+            argument->setName(llvm::StringRef(parameter->value.data(), parameter->value.size()));
+            if (argument->getType()->isPointerTy()) {
+                slots[parameter->symbol] = argument;
+            } else {
+                builder.CreateStore(argument, slots[parameter->symbol]);
             }
         }
 
-        if (!function->back().getTerminator()) {
+        generateStatements(ast->children, cg, slots);
+
+        if (!builder.GetInsertBlock()->getTerminator()) {
             builder.CreateRet(builder.getInt32(0));
-            log::debug("Added default return value for function: " + ast->value);
+            log::debug("Added default return value for function: {}", ast->value);
+        }
+        for (llvm::BasicBlock* errorBlock : slots.errorBlocks) {
+            if (errorBlock) errorBlock->insertInto(function);
         }
 
         std::string errorMsg;
         llvm::raw_string_ostream errorStream(errorMsg);
         if (llvm::verifyFunction(*function, &errorStream)) {
-            log::error("LLVM function verification failed for: " + ast->value);
-            log::error("Verification error: " + errorStream.str());
+            log::error("LLVM function verification failed for: {}", ast->value);
+            log::error("Verification error: {}", errorStream.str());
             return;
         }
 
-        log::debug("Function verified successfully: " + ast->value);
+        log::debug("Function verified successfully: {}", ast->value);
     } else {
-        log::debug("Unhandled AST node type: " + ast->type);
+        log::debug("Unhandled AST node type: {}", nodeKindName(ast->kind));
+    }
+}
+
+/**
+ * @brief Function to declare the runtime error handler, with a weak definition that prints the
+ *        error and exits; code run in-process binds the handler to the host's instead
+ */
+static llvm::Function* runtimeErrorHandler(CodeGenerator& cg) {
+    if (llvm::Function* existing = cg.module().getFunction(RUNTIME_ERROR_HANDLER)) {
+        return existing;
+    }
+    llvm::LLVMContext& context = cg.context();
+    llvm::Module& module = cg.module();
+    llvm::IRBuilder<> builder(context); // the generator's builder is inside the function being generated
+    llvm::Type* int32 = builder.getInt32Ty();
+    llvm::Function* handler = llvm::Function::Create(llvm::FunctionType::get(builder.getVoidTy(), {int32}, false),
+                                                     llvm::Function::WeakAnyLinkage, RUNTIME_ERROR_HANDLER, &module);
+    handler->addFnAttr(llvm::Attribute::NoReturn);
+    handler->addFnAttr(llvm::Attribute::NoUnwind);
+    handler->addFnAttr(llvm::Attribute::Cold);
+
+    llvm::FunctionCallee write = module.getOrInsertFunction(
+        "write", builder.getInt64Ty(), int32, builder.getInt8PtrTy(), builder.getInt64Ty());
+    llvm::FunctionCallee exit = module.getOrInsertFunction("exit", builder.getVoidTy(), int32);
+    llvm::BasicBlock* done = llvm::BasicBlock::Create(context, "exit", handler);
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(context, "entry", handler, done);
+    builder.SetInsertPoint(entry);
+    llvm::SwitchInst* kinds = builder.CreateSwitch(handler->getArg(0), done, RUNTIME_ERROR_KINDS - 1);
+    for (int32_t kind = 1; kind < RUNTIME_ERROR_KINDS; ++kind) {
+        std::string message = "Runtime error: " + std::string(runtimeErrorMessage(static_cast<RuntimeError>(kind))) + "\n";
+        llvm::BasicBlock* block = llvm::BasicBlock::Create(context, "report", handler, done);
+        kinds->addCase(builder.getInt32(kind), block);
+        builder.SetInsertPoint(block);
+        builder.CreateCall(write, {builder.getInt32(2), builder.CreateGlobalStringPtr(message, "nv.runtime.message", 0, &module),
+                                   builder.getInt64(message.size())});
+        builder.CreateBr(done);
+    }
+    builder.SetInsertPoint(done);
+    builder.CreateCall(exit, {builder.getInt32(1)});
+    builder.CreateUnreachable();
+    return handler;
+}
+
+/**
+ * @brief Function to branch to the function's error block unless a runtime check passes, code
+ *        generated afterwards continues in a new block
+ * @param passed i1, true if the check passed
+ */
+static void checkRuntime(llvm::Value* passed, RuntimeError error, CodeGenerator& cg, FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    llvm::LLVMContext& context = cg.context();
+    llvm::BasicBlock*& errorBlock = slots.errorBlocks[static_cast<size_t>(error)];
+    if (!errorBlock) {
+        // placed at the end of the function once it is generated
+        errorBlock = llvm::BasicBlock::Create(context, error == RuntimeError::DivisionByZero ? "div.error" : "index.error");
+        llvm::IRBuilder<> errorBuilder(errorBlock);
+        llvm::CallInst* call = errorBuilder.CreateCall(runtimeErrorHandler(cg), {errorBuilder.getInt32(static_cast<int32_t>(error))});
+        call->setDoesNotReturn();
+        errorBuilder.CreateUnreachable();
     }
+    llvm::BasicBlock* next = llvm::BasicBlock::Create(context, "check.ok", slots.function);
+    // the passing edge first and likely, the shape range check elimination looks for
+    builder.CreateCondBr(passed, next, errorBlock, llvm::MDBuilder(context).createBranchWeights(1 << 20, 1));
+    builder.SetInsertPoint(next);
 }
 
+/**
+ * @brief Function to get the address of an array element, a[i]; an index that is not a
+ *        constant is checked against the array's length
+ * @param index Value of the index expression
+ */
+static llvm::Value* elementPointer(ASTNode* ast, llvm::Value* index, CodeGenerator& cg, FunctionSlots& slots) {
+    if (!slots.contains(ast->symbol) || !slots[ast->symbol]) {
+        handleError("Array not resolved: " + std::string(ast->value));
+    }
+    llvm::IRBuilder<>& builder = cg.builder();
+    uint32_t length = slots.symbolTable->getSymbol(ast->symbol).length;
+    // constant indices are checked by semantic analysis; unsigned, so negative indices fail as well
+    if (!llvm::isa<llvm::ConstantInt>(index)) {
+        checkRuntime(builder.CreateICmpULT(index, builder.getInt32(length), "inbounds"), RuntimeError::IndexOutOfBounds,
+                     cg, slots);
+    }
+    // sign extended, so a negative index stays out of bounds instead of wrapping into them
+    llvm::Value* offset = builder.CreateSExt(index, builder.getInt64Ty(), "idxprom");
+    llvm::Type* type = arrayType(length, cg);
+    return builder.CreateInBoundsGEP(type, slots[ast->symbol], {builder.getInt64(0), offset}, "elementptr");
+}
 
+static llvm::CmpInst::Predicate comparisonPredicate(BinaryOperator op) {
+    switch (op) {
+    case BinaryOperator::Less: return llvm::CmpInst::ICMP_SLT;
+    case BinaryOperator::LessEqual: return llvm::CmpInst::ICMP_SLE;
+    case BinaryOperator::Greater: return llvm::CmpInst::ICMP_SGT;
+    case BinaryOperator::GreaterEqual: return llvm::CmpInst::ICMP_SGE;
+    case BinaryOperator::Equal: return llvm::CmpInst::ICMP_EQ;
+    default: return llvm::CmpInst::ICMP_NE;
+    }
+}
 
+/**
+ * @brief Function to generate a branch condition as an i1, a comparison is used directly
+ *        instead of being widened to an int and compared against zero again
+ */
+static llvm::Value* generateCondition(ASTNode* ast, CodeGenerator& cg, FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    if (ast->kind == NodeKind::BinaryOp) {
+        BinaryOperator op = binaryOperator(ast->value);
+        if (isComparison(op)) {
+            llvm::Value* lhs = generateExpression(ast->children[0], cg, slots);
+            llvm::Value* rhs = generateExpression(ast->children[1], cg, slots);
+            return builder.CreateICmp(comparisonPredicate(op), lhs, rhs, "cmptmp");
+        }
+    }
+    return builder.CreateICmpNE(generateExpression(ast, cg, slots), builder.getInt32(0), "tobool");
+}
 
-llvm::Value* generateExpression(ASTNode* ast, std::map<std::string, llvm::Value*>& variableMap) {
-    if (!ast) {
-        handleError("ASTNode is null in generateExpression");
+/**
+ * @brief Function to generate a loop. The condition is tested in its own block, the step
+ *        (for loops) in a latch the body falls through to, giving LLVM's loop passes the
+ *        canonical shape they rotate and vectorize.
+ * @param step Step assignment, null for a while loop
+ */
+static void generateLoop(ASTNode* condition, ASTNode* step, ASTNode* body, CodeGenerator& cg, FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    llvm::LLVMContext& context = cg.context();
+    llvm::BasicBlock* header = llvm::BasicBlock::Create(context, "loop.cond", slots.function);
+    llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(context, "loop.body", slots.function);
+    // placed once the body is generated, so blocks follow source order
+    llvm::BasicBlock* latch = step ? llvm::BasicBlock::Create(context, "loop.step") : header;
+    llvm::BasicBlock* exit = llvm::BasicBlock::Create(context, "loop.end");
+
+    builder.CreateBr(header);
+    builder.SetInsertPoint(header);
+    builder.CreateCondBr(generateCondition(condition, cg, slots), bodyBlock, exit);
+
+    builder.SetInsertPoint(bodyBlock);
+    generateStatements(body->children, cg, slots);
+    if (!builder.GetInsertBlock()->getTerminator()) {
+        builder.CreateBr(latch);
+    }
+
+    if (step) {
+        latch->insertInto(slots.function);
+        builder.SetInsertPoint(latch);
+        generateStatement(step, cg, slots);
+        builder.CreateBr(header);
     }
-    log::debug("Processing ASTNode of type: " + ast->type);
+    exit->insertInto(slots.function);
+    builder.SetInsertPoint(exit);
+}
 
-    if (ast->type == "Literal") {
-        log::debug("Converting Literal: " + ast->value);
-        return llvm::ConstantInt::get(builder.getInt32Ty(), std::stoi(ast->value));
+static void generateIf(ASTNode* ast, CodeGenerator& cg, FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    llvm::LLVMContext& context = cg.context();
+    bool hasElse = ast->children.size() > 2;
+    llvm::BasicBlock* thenBlock = llvm::BasicBlock::Create(context, "if.then", slots.function);
+    llvm::BasicBlock* elseBlock = hasElse ? llvm::BasicBlock::Create(context, "if.else") : nullptr;
+    llvm::BasicBlock* merge = llvm::BasicBlock::Create(context, "if.end");
+    builder.CreateCondBr(generateCondition(ast->children[0], cg, slots), thenBlock, hasElse ? elseBlock : merge);
+
+    builder.SetInsertPoint(thenBlock);
+    generateStatements(ast->children[1]->children, cg, slots);
+    bool reachesMerge = !hasElse;
+    if (!builder.GetInsertBlock()->getTerminator()) {
+        builder.CreateBr(merge);
+        reachesMerge = true;
+    }
+    if (hasElse) {
+        elseBlock->insertInto(slots.function);
+        builder.SetInsertPoint(elseBlock);
+        ASTNode* otherwise = ast->children[2];
+        generateStatements(otherwise->kind == NodeKind::If ? NodeList{&ast->children.data[2], 1} : otherwise->children,
+                           cg, slots);
+        if (!builder.GetInsertBlock()->getTerminator()) {
+            builder.CreateBr(merge);
+            reachesMerge = true;
+        }
     }
 
-    if (ast->type == "Variable") {
-        if (variableMap.count(ast->value) == 0) {
-            handleError("Variable not found in variableMap: " + ast->value);
+    if (!reachesMerge) {
+        // both branches return, whatever follows the if is unreachable and is not generated
+        delete merge;
+        return;
+    }
+    merge->insertInto(slots.function);
+    builder.SetInsertPoint(merge);
+}
+
+static void generateStatement(ASTNode* statement, CodeGenerator& cg, FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    switch (statement->kind) {
+    case NodeKind::VariableDeclaration: {
+        std::string_view varName = statement->value;
+        log::debug("Processing VariableDeclaration: {}", varName);
+        if (statement->children.empty() || !slots.contains(statement->symbol) || !slots[statement->symbol]) {
+            handleError("Invalid initialization for variable: " + std::string(varName));
+        }
+
+        // the initializer is the last child, an optional Type node precedes it; arrays have none and start zeroed
+        ASTNode* initializer = statement->children[statement->children.size() - 1];
+        if (initializer->kind == NodeKind::Type) {
+            uint64_t bytes = uint64_t(initializer->number) * sizeof(int32_t);
+            builder.CreateMemSet(slots[statement->symbol], builder.getInt8(0), bytes, llvm::MaybeAlign(ARRAY_ALIGNMENT));
+            break;
         }
-        return builder.CreateLoad(builder.getInt32Ty(), variableMap[ast->value], ast->value);
+        llvm::Value* initValue = generateExpression(initializer, cg, slots);
+        if (!initValue) {
+            handleError("Failed to generate initialization value for: " + std::string(varName));
+        }
+        builder.CreateStore(initValue, slots[statement->symbol]);
+        log::debug("Declared variable: {} with type int", varName);
+        break;
     }
+    case NodeKind::Assignment: {
+        ASTNode* target = statement->children[0];
+        llvm::Value* address = nullptr;
+        if (target->kind == NodeKind::Index) {
+            address = elementPointer(target, generateExpression(target->children[0], cg, slots), cg, slots);
+        }
+        if (!address) {
+            if (!slots.contains(target->symbol) || !slots[target->symbol]) {
+                handleError("Variable not resolved: " + std::string(target->value));
+            }
+            address = slots[target->symbol];
+        }
+        builder.CreateStore(generateExpression(statement->children[1], cg, slots), address);
+        break;
+    }
+    case NodeKind::ReturnStatement: {
+        if (statement->children.empty() || !statement->children[0]) {
+            handleError("Return statement has no value");
+        }
+        builder.CreateRet(generateExpression(statement->children[0], cg, slots));
+        log::debug("Added return value");
+        break;
+    }
+    case NodeKind::Call:
+        generateExpression(statement, cg, slots);
+        break;
+    case NodeKind::Block:
+        generateStatements(statement->children, cg, slots);
+        break;
+    case NodeKind::If:
+        generateIf(statement, cg, slots);
+        break;
+    case NodeKind::While:
+        generateLoop(statement->children[0], nullptr, statement->children[1], cg, slots);
+        break;
+    case NodeKind::For:
+        generateStatement(statement->children[0], cg, slots);
+        generateLoop(statement->children[1], statement->children[2], statement->children[3], cg, slots);
+        break;
+    default:
+        break; // parameters, stored on entry
+    }
+}
 
-    if (ast->type == "BinaryOp") {
-        log::debug("Generating BinaryOp for operator: " + ast->value);
-        llvm::Value* lhs = generateExpression(ast->children[0], variableMap);
-        llvm::Value* rhs = generateExpression(ast->children[1], variableMap);
+static void generateStatements(NodeList statements, CodeGenerator& cg, FunctionSlots& slots) {
+    for (auto* statement : statements) {
+        if (!statement) {
+            handleError("ASTNode child is null in CodeGenerator::generate");
+        }
+        // statements after a return are unreachable, the block is already terminated
+        if (cg.builder().GetInsertBlock()->getTerminator()) {
+            return;
+        }
+        generateStatement(statement, cg, slots);
+    }
+}
 
+/**
+ * @brief Function to generate a division the way the interpreter runs it: dividing by zero is a
+ *        runtime error and INT_MIN / -1 wraps to INT_MIN, neither is undefined
+ */
+static llvm::Value* generateDivision(llvm::Value* lhs, llvm::Value* rhs, CodeGenerator& cg, FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    auto* constant = llvm::dyn_cast<llvm::ConstantInt>(rhs);
+    if (constant && !constant->isZero() && !constant->isMinusOne()) {
+        return builder.CreateSDiv(lhs, rhs, "divtmp");
+    }
+    checkRuntime(builder.CreateICmpNE(rhs, builder.getInt32(0), "nonzero"), RuntimeError::DivisionByZero, cg, slots);
+    // without branches, so a divisor that does not change in a loop leaves it vectorizable
+    llvm::Value* negate = builder.CreateICmpEQ(rhs, builder.getInt32(-1), "divneg");
+    llvm::Value* quotient = builder.CreateSDiv(lhs, builder.CreateSelect(negate, builder.getInt32(1), rhs), "divtmp");
+    return builder.CreateSelect(negate, builder.CreateSub(builder.getInt32(0), lhs, "negtmp"), quotient, "divres");
+}
+
+/**
+ * @brief Function to generate a node of an expression whose operands are generated
+ * @param operands Values of the node's children, in order
+ */
+static llvm::Value* generateOperation(ASTNode* ast, llvm::Value* const* operands, CodeGenerator& cg,
+                                      FunctionSlots& slots) {
+    llvm::IRBuilder<>& builder = cg.builder();
+    log::debug("Processing ASTNode of type: {}", nodeKindName(ast->kind));
+
+    switch (ast->kind) {
+    case NodeKind::Literal: {
+        log::debug("Converting Literal: {}", ast->number);
+        return llvm::ConstantInt::get(builder.getInt32Ty(), ast->number, true);
+    }
+    case NodeKind::Variable: {
+        if (!slots.contains(ast->symbol) || !slots[ast->symbol]) {
+            handleError("Variable not resolved: " + std::string(ast->value));
+        }
+        // an array is only named as a call argument, it is passed by reference and its storage is the value
+        if (slots.symbolTable->getSymbol(ast->symbol).type == ValueType::IntArray) {
+            return slots[ast->symbol];
+        }
+        return builder.CreateLoad(builder.getInt32Ty(), slots[ast->symbol], ast->value);
+    }
+    case NodeKind::Index:
+        return builder.CreateLoad(builder.getInt32Ty(), elementPointer(ast, operands[0], cg, slots), ast->value);
+    case NodeKind::Call: {
+        llvm::Function* callee = declareFunction(ast->symbol, *slots.symbolTable, cg);
+        if (callee->arg_size() != ast->children.size()) {
+            handleError("Wrong number of arguments in call to: " + std::string(ast->value));
+        }
+        return builder.CreateCall(callee, llvm::ArrayRef<llvm::Value*>(operands, ast->children.size()), "calltmp");
+    }
+    case NodeKind::BinaryOp: {
+        log::debug("Generating BinaryOp for operator: {}", ast->value);
+        BinaryOperator op = binaryOperator(ast->value);
+        llvm::Value* lhs = operands[0];
+        llvm::Value* rhs = operands[1];
         if (!lhs || !rhs) {
-            handleError("Failed to generate operands for BinaryOp: " + ast->value);
+            handleError("Failed to generate operands for BinaryOp: " + std::string(ast->value));
+        }
+        if (isComparison(op)) {
+            llvm::Value* comparison = builder.CreateICmp(comparisonPredicate(op), lhs, rhs, "cmptmp");
+            return builder.CreateZExt(comparison, builder.getInt32Ty(), "booltmp");
         }
 
-        if (ast->value == "+") return builder.CreateAdd(lhs, rhs, "addtmp");
-        if (ast->value == "-") return builder.CreateSub(lhs, rhs, "subtmp");
-        if (ast->value == "*") return builder.CreateMul(lhs, rhs, "multmp");
-        if (ast->value == "/") return builder.CreateSDiv(lhs, rhs, "divtmp");
+        switch (op) {
+        case BinaryOperator::Add: return builder.CreateAdd(lhs, rhs, "addtmp");
+        case BinaryOperator::Subtract: return builder.CreateSub(lhs, rhs, "subtmp");
+        case BinaryOperator::Multiply: return builder.CreateMul(lhs, rhs, "multmp");
+        case BinaryOperator::Divide: return generateDivision(lhs, rhs, cg, slots);
+        default: break;
+        }
 
-        handleError("Unknown operator in BinaryOp: " + ast->value);
+        handleError("Unknown operator in BinaryOp: " + std::string(ast->value));
+        break;
+    }
+    default:
+        break;
     }
 
-    handleError("Unhandled ASTNode type: " + ast->type);
+    handleError(std::string("Unhandled ASTNode type: ") + nodeKindName(ast->kind));
     return nullptr;
 }
 
+llvm::Value* generateExpression(ASTNode* ast, CodeGenerator& cg, FunctionSlots& slots) {
+    if (!ast) {
+        handleError("ASTNode is null in generateExpression");
+    }
+    if (ast->children.empty()) {
+        return generateOperation(ast, nullptr, cg, slots);
+    }
+    // operands are generated before the node using them, in source order, and wait on a stack
+    // until then; no recursion, so expressions of any depth are safe to generate
+    std::vector<llvm::Value*> values;
+    forEachNodePostOrder(ast, [&](ASTNode* node) {
+        if (node->kind == NodeKind::Variable) {
+            values.push_back(nullptr); // loaded by the node using it, see below
+            return;
+        }
+        // a variable is loaded right before its use; no call can assign it, and the operands
+        // waiting for a deeply nested right operand then hold no loaded values alive across it
+        size_t first = values.size() - node->children.size();
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            if (!values[first + i]) {
+                values[first + i] = generateOperation(node->children[i], nullptr, cg, slots);
+            }
+        }
+        llvm::Value* value = generateOperation(node, values.data() + first, cg, slots);
+        values.resize(first);
+        values.push_back(value);
+        if (++slots.blockNodes == BLOCK_EXPRESSION_NODES) {
+            llvm::BasicBlock* next = llvm::BasicBlock::Create(cg.context(), "expr.cont", slots.function);
+            cg.builder().CreateBr(next);
+            cg.builder().SetInsertPoint(next);
+            slots.blockNodes = 0;
+        }
+    });
+    return values.back();
+}
+
 
 
 
-void printLLVMIR(const std::string& filename) {
-    log::debug("Printing LLVM IR to file: " + filename);
+bool printLLVMIR(const llvm::Module& module, const std::string& filename) {
+    log::debug("Printing LLVM IR to file: {}", filename);
     std::error_code EC;
     llvm::raw_fd_ostream dest(filename, EC);
     if (EC) {
-        llvm::errs() << "Could not open file: " << EC.message() << "\n";
-        return;
+        log::error("Could not open file {}: {}", filename, EC.message());
+        return false;
     }
-    module->print(dest, nullptr);
+    module.print(dest, nullptr);
     dest.close();
+    if (dest.has_error()) {
+        log::error("Could not write file {}: {}", filename, dest.error().message());
+        dest.clear_error();
+        return false;
+    }
+    return true;
 }
@@ -2,14 +2,69 @@
 #define LLVM_GENERATOR_H
 
 #include "../parser/parser.h"
+#include "../analysis/analysis.h"
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
+#include <memory>
 
-void initializeLLVM();
+/**
+ * @brief Generates LLVM IR into a module it owns, together with the context and builder the
+ *        module is built with. Generators share nothing, so one per thread can run concurrently.
+ *        Once the module is taken the generator can be reset and reused; if the context was kept
+ *        the next module starts without creating a context and reuses the types already in it.
+ */
+class CodeGenerator {
+public:
+    CodeGenerator();
 
-void generateLLVMIR(ASTNode* ast);
+    CodeGenerator(const CodeGenerator&) = delete;
+    CodeGenerator& operator=(const CodeGenerator&) = delete;
 
-void printLLVMIR(const std::string& filename);
+    /**
+     * @brief Function to generate LLVM IR for a program or function node into the module
+     * @param ast AST node, resolved by semanticAnalysis
+     * @param symbolTable Table the AST was resolved against, variables are looked up by slot
+     * @throws CompileError if the AST cannot be generated
+     */
+    void generate(ASTNode* ast, const SymbolTable& symbolTable);
+
+    /**
+     * @brief Function to take ownership of the generated module. It lives in the generator's
+     *        context, which must be taken as well if the module outlives the generator.
+     * @return Module, the generator holds none until reset
+     */
+    std::unique_ptr<llvm::Module> takeModule();
+
+    /**
+     * @brief Function to take ownership of the context the module was built in
+     * @return Context, must outlive the module returned by takeModule
+     */
+    std::unique_ptr<llvm::LLVMContext> takeContext();
+
+    /**
+     * @brief Function to start a new, empty module. A module still held is discarded, a new
+     *        context is only created if the previous one was taken.
+     */
+    void reset();
+
+    llvm::LLVMContext& context() { return *llvmContext; }
+    llvm::Module& module() { return *llvmModule; }
+    llvm::IRBuilder<>& builder() { return *irBuilder; }
+
+private:
+    // the context is declared first so it is destroyed after the builder and module that refer to it
+    std::unique_ptr<llvm::LLVMContext> llvmContext;
+    std::unique_ptr<llvm::IRBuilder<>> irBuilder;
+    std::unique_ptr<llvm::Module> llvmModule;
+};
+
+/**
+ * @brief Function to write a module as textual LLVM IR
+ * @param module Module to print
+ * @param filename Output path
+ * @return false if the file could not be written
+ */
+bool printLLVMIR(const llvm::Module& module, const std::string& filename);
 
 #endif // LLVM_GENERATOR_H
@@ -0,0 +1,288 @@
+#include "logger.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct Record {
+    LogLevel level;
+    std::time_t time;
+    std::string message;
+};
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::NONE: break;
+    }
+    return "NONE";
+}
+
+/**
+ * @brief "HH:MM:SS" of a point in time, reformatted only when the second changes
+ */
+class TimestampCache {
+public:
+    const char* format(std::time_t time) {
+        if (time != cachedTime) {
+            std::tm tm;
+            localtime_r(&time, &tm); // i think this wont work in windows
+            std::strftime(text, sizeof(text), "%H:%M:%S", &tm);
+            cachedTime = time;
+        }
+        return text;
+    }
+
+private:
+    std::time_t cachedTime = -1;
+    char text[16] = {};
+};
+
+void appendRecord(std::string& out, const Record& record, TimestampCache& timestamps) {
+    out += '[';
+    out += timestamps.format(record.time);
+    out += " | ";
+    out += levelName(record.level);
+    out += "] ";
+    out += record.message;
+    out += '\n';
+}
+
+/**
+ * @brief Bounded multi-producer single-consumer ring. Every slot carries a sequence
+ *        number, producers claim a position with one CAS and publish by bumping the
+ *        slot's sequence, so neither side ever takes a lock.
+ */
+class RecordQueue {
+public:
+    explicit RecordQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask = size - 1;
+        slots = std::make_unique<Slot[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(Record& record) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.record = std::move(record);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false; // full
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(Record& record) {
+        Slot& slot = slots[dequeuePosition & mask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != dequeuePosition + 1) {
+            return false; // empty, or the producer has not published yet
+        }
+        record = std::move(slot.record);
+        slot.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+        ++dequeuePosition;
+        return true;
+    }
+
+    bool empty() const {
+        return slots[dequeuePosition & mask].sequence.load(std::memory_order_acquire) != dequeuePosition + 1;
+    }
+
+    size_t claimed() const { return enqueuePosition.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePosition{0};
+    alignas(64) size_t dequeuePosition = 0; // consumer only
+};
+
+class AsyncWriter {
+public:
+    explicit AsyncWriter(size_t capacity) : queue(capacity), thread([this] { run(); }) {}
+
+    ~AsyncWriter() {
+        stopping.store(true, std::memory_order_release);
+        wake();
+        thread.join();
+    }
+
+    void push(Record&& record) {
+        bool mayDrop = record.level < LogLevel::WARN;
+        while (!queue.tryPush(record)) {
+            if (mayDrop) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wake();
+            std::this_thread::yield();
+        }
+        if (sleeping.load(std::memory_order_acquire)) {
+            wake();
+        }
+    }
+
+    void flush() {
+        size_t target = queue.claimed();
+        wake();
+        std::unique_lock<std::mutex> lock(mutex);
+        flushed.wait(lock, [&] { return written >= target; });
+    }
+
+private:
+    void wake() {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.notify_one();
+    }
+
+    void run() {
+        std::string batch;
+        TimestampCache timestamps;
+        Record record;
+
+        while (true) {
+            size_t count = 0;
+            while (count < 1024 && queue.tryPop(record)) {
+                appendRecord(batch, record, timestamps);
+                ++count;
+            }
+
+            size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+            if (lost) {
+                appendRecord(batch, {LogLevel::WARN, std::time(nullptr), std::to_string(lost) + " log records dropped"},
+                             timestamps);
+            }
+
+            if (!batch.empty()) {
+                std::fwrite(batch.data(), 1, batch.size(), stdout);
+                batch.clear();
+            }
+
+            if (count == 0) {
+                std::fflush(stdout);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    written += processed;
+                    processed = 0;
+                }
+                flushed.notify_all();
+
+                if (stopping.load(std::memory_order_acquire)) {
+                    // records pushed before stopAsync are visible now, drain them before exiting
+                    if (queue.empty()) return;
+                    continue;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    sleeping.store(true, std::memory_order_release);
+                    pending.wait_for(lock, std::chrono::milliseconds(50));
+                    sleeping.store(false, std::memory_order_release);
+                }
+                continue;
+            }
+            processed += count;
+        }
+    }
+
+    RecordQueue queue;
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> sleeping{false};
+    std::mutex mutex;
+    std::condition_variable pending;
+    std::condition_variable flushed;
+    size_t processed = 0; // writer thread only
+    size_t written = 0;   // records written and flushed, guarded by mutex
+    std::thread thread;
+};
+
+std::mutex writerMutex; // guards starting and stopping, never taken on the logging path
+std::atomic<AsyncWriter*> writer{nullptr};
+
+void writeSynchronously(const Record& record) {
+    thread_local TimestampCache timestamps;
+    thread_local std::string line;
+    line.clear();
+    appendRecord(line, record, timestamps);
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    if (record.level >= LogLevel::WARN) {
+        std::fflush(stdout);
+    }
+}
+
+} // namespace
+
+void log::logWithLevel(std::string &&message, LogLevel level)
+{
+    Record record{level, std::time(nullptr), std::move(message)};
+    if (AsyncWriter* active = writer.load(std::memory_order_acquire)) {
+        active->push(std::move(record));
+    } else {
+        writeSynchronously(record);
+    }
+}
+
+void log::startAsync(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (writer.load()) {
+        return;
+    }
+    writer.store(new AsyncWriter(capacity), std::memory_order_release);
+
+    // make sure queued records reach the terminal on std::exit and std::terminate too
+    static bool hooksInstalled = false;
+    if (!hooksInstalled) {
+        hooksInstalled = true;
+        std::atexit([] { log::stopAsync(); });
+        static std::terminate_handler previous = std::set_terminate([] {
+            log::flush();
+            if (previous) previous();
+            std::abort();
+        });
+    }
+}
+
+void log::flush()
+{
+    if (AsyncWriter* active = writer.load(std::memory_order_acquire)) {
+        active->flush();
+    }
+    std::fflush(stdout);
+}
+
+void log::stopAsync()
+{
+    std::lock_guard<std::mutex> lock(writerMutex);
+    AsyncWriter* active = writer.exchange(nullptr, std::memory_order_acq_rel);
+    delete active; // drains the queue before joining
+    std::fflush(stdout);
+}
@@ -1,63 +1,172 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
 #include <iostream>
+#include <cstddef>
+#include <sstream>
 #include <string>
-#include <ctime>
-#include <iomanip>
+#include <string_view>
+#include <type_traits>
 
-const std::string loglevel = "DEBUG";
+enum class LogLevel {
+    DEBUG = 0,
+    INFO = 1,
+    WARN = 2,
+    ERROR = 3,
+    NONE = 4
+};
+
+// lowest level compiled into the binary, e.g. -DNOVA_LOG_LEVEL=1 strips every debug call
+#ifndef NOVA_LOG_LEVEL
+#define NOVA_LOG_LEVEL 0
+#endif
+
+constexpr LogLevel compiledLogLevel = static_cast<LogLevel>(NOVA_LOG_LEVEL);
 
 class log
 {
 public:
     /**
-     * @brief Function to log DEBUG message
+     * @brief Function to set the runtime log level, levels below the compiled one stay off
+     */
+    static void setLevel(LogLevel level)
+    {
+        runtimeLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+    /**
+     * @brief Function to get the runtime log level
+     */
+    static LogLevel level()
+    {
+        return static_cast<LogLevel>(runtimeLevel.load(std::memory_order_relaxed));
+    }
+    /**
+     * @brief Function to check if records of a level are emitted, one integer compare at runtime
+     */
+    static bool enabled(LogLevel level)
+    {
+        return level >= compiledLogLevel &&
+               static_cast<int>(level) >= runtimeLevel.load(std::memory_order_relaxed);
+    }
+    /**
+     * @brief Function to parse a level name (debug, info, warn, error, none)
+     * @return false if the name is unknown
+     */
+    static bool parseLevel(std::string_view name, LogLevel& level)
+    {
+        if (name == "debug") level = LogLevel::DEBUG;
+        else if (name == "info") level = LogLevel::INFO;
+        else if (name == "warn") level = LogLevel::WARN;
+        else if (name == "error") level = LogLevel::ERROR;
+        else if (name == "none") level = LogLevel::NONE;
+        else return false;
+        return true;
+    }
+
+    /**
+     * @brief Function to start the background writer. Records are then queued in a
+     *        bounded lock-free ring and written in batches; when the ring is full
+     *        DEBUG and INFO records are dropped and counted, WARN and ERROR wait.
+     * @param capacity Ring size in records, rounded up to a power of two
+     */
+    static void startAsync(size_t capacity = 8192);
+    /**
+     * @brief Function to block until every record queued so far has been written and flushed
+     */
+    static void flush();
+    /**
+     * @brief Function to drain the queue and stop the background writer, no other thread may log concurrently
+     */
+    static void stopAsync();
+
+    /**
+     * @brief Function to log DEBUG message, each {} in format is replaced by the next argument.
+     *        Nothing is formatted unless the record is emitted.
      */
-    static void debug(const std::string &message)
-    {   
-        if (loglevel != "DEBUG") return;
-        logWithLevel(message, "DEBUG");
+    template <typename... Args>
+    static void debug(std::string_view format, const Args&... args)
+    {
+        if constexpr (compiledLogLevel <= LogLevel::DEBUG) {
+            if (enabled(LogLevel::DEBUG)) logWithLevel(formatMessage(format, args...), LogLevel::DEBUG);
+        }
     }
     /**
      * @brief Function to log INFO message
      */
-    static void info(const std::string &message)
-    {   
-        if (loglevel != "DEBUG" && loglevel != "INFO") return;
-        logWithLevel(message, "INFO");
+    template <typename... Args>
+    static void info(std::string_view format, const Args&... args)
+    {
+        if constexpr (compiledLogLevel <= LogLevel::INFO) {
+            if (enabled(LogLevel::INFO)) logWithLevel(formatMessage(format, args...), LogLevel::INFO);
+        }
     }
     /**
      * @brief Function to log WARN message
      */
-    static void warn(const std::string &message)
+    template <typename... Args>
+    static void warn(std::string_view format, const Args&... args)
     {
-        if (loglevel != "DEBUG" && loglevel != "INFO" && loglevel != "WARN") return;
-        logWithLevel(message, "WARN");
+        if constexpr (compiledLogLevel <= LogLevel::WARN) {
+            if (enabled(LogLevel::WARN)) logWithLevel(formatMessage(format, args...), LogLevel::WARN);
+        }
     }
     /**
      * @brief Function to log ERROR message
      */
-    static void error(const std::string &message)
+    template <typename... Args>
+    static void error(std::string_view format, const Args&... args)
     {
-        logWithLevel(message, "ERROR");
+        if constexpr (compiledLogLevel <= LogLevel::ERROR) {
+            if (enabled(LogLevel::ERROR)) logWithLevel(formatMessage(format, args...), LogLevel::ERROR);
+        }
     }
 
 private:
-    static void logWithLevel(const std::string &message, const std::string &level)
+    static inline std::atomic<int> runtimeLevel{static_cast<int>(LogLevel::INFO)};
+
+    template <typename T>
+    static void appendArgument(std::string& out, const T& value)
     {
-        std::cout << "[" << currentTimestamp() << " | " << level << "] " << message << std::endl;
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            out += std::string_view(value);
+        } else if constexpr (std::is_same_v<T, char>) {
+            out += value;
+        } else if constexpr (std::is_integral_v<T>) {
+            out += std::to_string(value);
+        } else {
+            std::ostringstream oss;
+            oss << value;
+            out += oss.str();
+        }
     }
 
-    static std::string currentTimestamp()
+    static void appendUntilPlaceholder(std::string& out, std::string_view& format)
     {
-        auto now = std::time(nullptr);
-        std::tm tm;
-        localtime_r(&now, &tm); // i think this wont work in windows
-        std::ostringstream oss;
-        oss << std::put_time(&tm, "%H:%M:%S");
-        return oss.str();
+        size_t placeholder = format.find("{}");
+        if (placeholder == std::string_view::npos) {
+            out += format;
+            format = {};
+        } else {
+            out += format.substr(0, placeholder);
+            format.remove_prefix(placeholder + 2);
+        }
     }
+
+    template <typename... Args>
+    static std::string formatMessage(std::string_view format, const Args&... args)
+    {
+        std::string out;
+        out.reserve(format.size() + 16 * sizeof...(Args));
+        ((appendUntilPlaceholder(out, format), appendArgument(out, args)), ...);
+        out += format;
+        return out;
+    }
+
+    /**
+     * @brief Function to hand a finished record to the sink, queued when the async writer runs
+     */
+    static void logWithLevel(std::string &&message, LogLevel level);
 };
 
 #endif // LOGGER_H
@@ -1,66 +1,44 @@
-#include <iostream>
-#include <string>
-#include <fstream>
+#include <chrono>
 #include "logger/logger.h"
-#include "tokenizer/tokenize.h"
-#include "parser/parser.h"
-#include "analysis/analysis.h"
-#include "llvm/llvm_generator.h"
-
-void read_file(const std::string &filename, std::string &content);
+#include "driver/options.h"
+#include "driver/driver.h"
+#include "server/server.h"
+#include "server/client.h"
+#include "server/protocol.h"
 
 int main(int argc, char** argv) {
+    auto startTime = std::chrono::steady_clock::now();
+    log::startAsync();
 
-    if (argc < 2) {
-        log::error("No input file provided as argument");
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        log::stopAsync();
+        printUsage();
         return 1;
     }
-
-    log::debug("Trying to read file stream");
-    std::string content = "";
-    read_file(argv[1], content);
-    log::debug("File content:\n" + content);
-    log::debug("Tokenizing file");
-    auto tokens = tokenize(content);
-    print_tokens(tokens);
-    log::debug("AST:");
-
-    Parser parser(tokens);
-    ASTNode* ast = parser.parse();
-    if (!ast) {
-        log::error("Failed to parse the input.");
-        return 1;
+    if (options.version) {
+        log::stopAsync();
+        printVersion();
+        return 0;
     }
-    printAST(ast);
-
-    SymbolTable symbolTable;
-    semanticAnalysis(ast, symbolTable);
-    log::debug("Semantic analysis completed");
-    initializeLLVM();
-    generateLLVMIR(ast);
-    log::debug("LLVM IR generated");
-
-    printLLVMIR("output.ll");
-
-    delete ast;
-    log::info("Compilation successful");
-    return 0;
-}
-
-
-
-void read_file(const std::string &filename, std::string &content) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        log::error("Failed to open file: " + filename);
-        return;
+    if (options.server) {
+        int status = runServer(options);
+        log::stopAsync();
+        return status;
     }
-    log::debug("Opened file: " + filename);
-    std::string line;
-    while (std::getline(file, line)) {
-        content += line + "\n";
+
+    int status = 0;
+    std::string socketPath = options.socketPath.empty() ? defaultSocketPath() : options.socketPath;
+    if (options.client && runClient(socketPath, argc, argv, status)) {
+        // the server already reported the outcome on our streams
+        log::stopAsync();
+        return status;
     }
-    file.close();
 
-    log::debug("Closed file: " + filename);
-}
\ No newline at end of file
+    status = compileAll(options, startTime);
+    if (status == 0 && !options.run && !options.interp) {
+        log::info("Compilation successful");
+    }
+    log::stopAsync();
+    return status;
+}
@@ -0,0 +1,278 @@
+#include "nova.h"
+#include "../parser/parser.h"
+#include "../analysis/analysis.h"
+#include "../optimizer/fold.h"
+#include "../llvm/llvm_generator.h"
+#include "../target/target.h"
+#include "../serialize/ast_file.h"
+#include "../jit/runtime.h"
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+#include <exception>
+#include <sstream>
+
+namespace nova {
+
+// constants and types stay interned in a context after their module is gone, so a context
+// generating module after module is replaced now and then to bound its memory
+static constexpr size_t CONTEXT_REUSE_LIMIT = 1000;
+
+struct Compiler::FrontEnd {
+    FrontEnd(std::string_view source, const CompileOptions& options)
+        : source(source), diagnostics(options.name, source, options.maxErrors) {}
+
+    std::string_view source;
+    DiagnosticEngine diagnostics;
+    Arena arena;
+    SymbolTable symbolTable;
+    ASTNode* ast = nullptr;
+};
+
+/**
+ * @brief Function to run a step of a compile, recording whatever it raises as a diagnostic
+ * @return false if the compile has errors afterwards
+ */
+template <typename Step>
+static bool guarded(DiagnosticEngine& diagnostics, Step step) {
+    try {
+        step();
+    } catch (const CompileError& error) {
+        diagnostics.report(error);
+    } catch (const ErrorLimitReached&) {
+        // recorded by the engine
+    } catch (const std::exception& error) {
+        diagnostics.error({}, std::string("internal compiler error: ") + error.what());
+    }
+    return !diagnostics.hasErrors();
+}
+
+static Diagnostics collect(const DiagnosticEngine& engine) {
+    Diagnostics result;
+    if (!engine.hasErrors()) {
+        return result;
+    }
+    for (const ::Diagnostic& diagnostic : engine.all()) {
+        Diagnostic& error = result.errors.emplace_back();
+        if (diagnostic.span.valid()) {
+            SourceLocation location = engine.locate(diagnostic.span.offset);
+            error.line = location.line;
+            error.column = location.column;
+            error.offset = diagnostic.span.offset;
+            error.length = diagnostic.span.length;
+        }
+        error.message = diagnostic.message;
+    }
+    std::ostringstream text;
+    engine.print(text);
+    result.text = text.str();
+    return result;
+}
+
+Program::Program(Program&& other) noexcept
+    : jit(std::move(other.jit)), library(other.library), errors(std::move(other.errors)), failure(other.failure) {
+    other.library = nullptr;
+}
+
+Program& Program::operator=(Program&& other) noexcept {
+    if (this != &other) {
+        release();
+        jit = std::move(other.jit);
+        library = other.library;
+        errors = std::move(other.errors);
+        failure = other.failure;
+        other.library = nullptr;
+    }
+    return *this;
+}
+
+Program::~Program() {
+    release();
+}
+
+void Program::release() {
+    if (library) {
+        llvm::consumeError(jit->getExecutionSession().removeJITDylib(*library));
+        library = nullptr;
+    }
+    jit.reset();
+}
+
+void* Program::lookup(std::string_view name) const {
+    if (!library) {
+        return nullptr;
+    }
+    auto symbol = jit->lookup(*library, llvm::StringRef(name.data(), name.size()));
+    if (!symbol) {
+        llvm::consumeError(symbol.takeError());
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(symbol->getAddress());
+}
+
+bool Program::runChecked(void (*call)(void*), void* context) const {
+    RuntimeError error = ::runChecked(call, context);
+    failure = error == RuntimeError::None ? nullptr : runtimeErrorMessage(error);
+    return !failure;
+}
+
+bool Program::runMain(int32_t& result) const {
+    return call("main", result);
+}
+
+Compiler::Compiler(CompileOptions options)
+    : options(std::move(options)), generator(std::make_unique<CodeGenerator>()) {}
+
+Compiler::~Compiler() = default;
+
+llvm::TargetMachine* Compiler::targetMachine() {
+    if (!host) {
+        host = createHostTargetMachine(options.optLevel);
+    }
+    return host.get();
+}
+
+bool Compiler::runFrontEnd(FrontEnd& frontEnd) {
+    return guarded(frontEnd.diagnostics, [&] {
+        Lexer lexer(frontEnd.source);
+        Parser parser(lexer, frontEnd.arena, frontEnd.diagnostics);
+        frontEnd.ast = parser.parse();
+        if (frontEnd.diagnostics.hasErrors()) return;
+        semanticAnalysis(frontEnd.ast, frontEnd.symbolTable, frontEnd.diagnostics);
+        if (frontEnd.diagnostics.hasErrors()) return;
+        foldConstants(frontEnd.ast, frontEnd.symbolTable);
+    });
+}
+
+bool Compiler::generate(FrontEnd& frontEnd) {
+    if (++modulesInContext > CONTEXT_REUSE_LIMIT) {
+        generator = std::make_unique<CodeGenerator>();
+        modulesInContext = 1;
+    }
+    generator->reset();
+    return guarded(frontEnd.diagnostics, [&] {
+        generator->generate(frontEnd.ast, frontEnd.symbolTable);
+        llvm::Module& module = generator->module();
+        std::string errors;
+        llvm::raw_string_ostream errorStream(errors);
+        if (llvm::verifyModule(module, &errorStream)) {
+            throw std::runtime_error("module verification failed: " + errorStream.str());
+        }
+        llvm::TargetMachine* machine = targetMachine();
+        if (machine) {
+            configureModuleForTarget(module, *machine);
+        }
+        optimizeModule(module, options.optLevel, machine, false);
+    });
+}
+
+Diagnostics Compiler::check(std::string_view source) {
+    FrontEnd frontEnd(source, options);
+    runFrontEnd(frontEnd);
+    return collect(frontEnd.diagnostics);
+}
+
+Artifact Compiler::compile(std::string_view source, EmitKind kind) {
+    Artifact artifact;
+    FrontEnd frontEnd(source, options);
+    if (kind == EmitKind::Executable) {
+        frontEnd.diagnostics.error({}, "Executables need the system linker, compile to an object file instead");
+    } else if (!runFrontEnd(frontEnd)) {
+        // nothing to generate
+    } else if (kind == EmitKind::AST) {
+        llvm::raw_string_ostream out(artifact.code);
+        serializeAST(frontEnd.ast, frontEnd.symbolTable, out);
+    } else if (generate(frontEnd)) {
+        guarded(frontEnd.diagnostics, [&] {
+            llvm::Module& module = generator->module();
+            if (kind == EmitKind::LLVM || kind == EmitKind::Bitcode) {
+                llvm::raw_string_ostream out(artifact.code);
+                if (kind == EmitKind::LLVM) {
+                    module.print(out, nullptr);
+                } else {
+                    llvm::WriteBitcodeToFile(module, out);
+                }
+                return;
+            }
+            llvm::TargetMachine* machine = targetMachine();
+            llvm::SmallVector<char, 0> code;
+            llvm::raw_svector_ostream out(code);
+            if (!machine || !emitNative(module, *machine, out, kind)) {
+                throw std::runtime_error("no native target available to emit code");
+            }
+            artifact.code.assign(code.data(), code.size());
+        });
+    }
+    artifact.diagnostics = collect(frontEnd.diagnostics);
+    if (!artifact.ok()) {
+        artifact.code.clear();
+    }
+    return artifact;
+}
+
+Program Compiler::load(std::string_view source) {
+    Program program;
+    FrontEnd frontEnd(source, options);
+    if (runFrontEnd(frontEnd) && generate(frontEnd)) {
+        bool loaded = guarded(frontEnd.diagnostics, [&] {
+            if (!jit) {
+                initializeNativeTarget();
+                auto machineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+                if (!machineBuilder) {
+                    throw std::runtime_error(llvm::toString(machineBuilder.takeError()));
+                }
+                // the JIT generates code at the level the IR was optimized at, -O0 gets the fast instruction selector
+                machineBuilder->setCodeGenOptLevel(codeGenLevel(options.optLevel));
+                auto created = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(*machineBuilder)).create();
+                if (!created) {
+                    throw std::runtime_error(llvm::toString(created.takeError()));
+                }
+                jit = std::move(*created);
+            }
+
+            // every program gets a library of its own, so programs may define the same names
+            auto library = jit->createJITDylib("program" + std::to_string(programsLoaded++));
+            if (!library) {
+                throw std::runtime_error(llvm::toString(library.takeError()));
+            }
+            program.jit = jit;
+            program.library = &*library;
+            // arrays are zeroed with memset, which comes from the host process
+            auto process = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+                jit->getDataLayout().getGlobalPrefix());
+            if (!process) {
+                throw std::runtime_error(llvm::toString(process.takeError()));
+            }
+            library->addGenerator(std::move(*process));
+            if (auto error = defineRuntime(*jit, *library)) {
+                throw std::runtime_error(llvm::toString(std::move(error)));
+            }
+
+            // the JIT owns the context from here on, the generator creates a new one for the next source
+            std::unique_ptr<llvm::Module> module = generator->takeModule();
+            std::unique_ptr<llvm::LLVMContext> context = generator->takeContext();
+            modulesInContext = 0;
+            if (auto error = jit->addIRModule(*library, llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+                throw std::runtime_error(llvm::toString(std::move(error)));
+            }
+
+            // compiled now rather than on the first call, so backend errors are reported here
+            for (const ASTNode* function : frontEnd.ast->children) {
+                auto symbol = jit->lookup(*program.library, llvm::StringRef(function->value.data(), function->value.size()));
+                if (!symbol) {
+                    throw std::runtime_error(llvm::toString(symbol.takeError()));
+                }
+            }
+        });
+        if (!loaded) {
+            program.release();
+        }
+    }
+    program.errors = collect(frontEnd.diagnostics);
+    return program;
+}
+
+} // namespace nova
@@ -0,0 +1,195 @@
+#ifndef NOVA_H
+#define NOVA_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../emit/emit.h"
+#include "../optimizer/optimizer.h"
+
+/**
+ * Embedding API, built into libnova.a by `make lib`. Sources are taken from memory and every
+ * result, code and errors alike, is returned to the caller; nothing is printed or written to
+ * disk. The compiler's internal log records still go to stdout at their usual levels, a host
+ * that wants none of them calls log::setLevel(LogLevel::NONE).
+ */
+
+class CodeGenerator;
+
+namespace llvm {
+class TargetMachine;
+namespace orc {
+class LLJIT;
+class JITDylib;
+} // namespace orc
+} // namespace llvm
+
+namespace nova {
+
+struct CompileOptions {
+    OptLevel optLevel = OptLevel::O0;
+    std::string name = "<memory>"; // name diagnostics refer to the source by
+    size_t maxErrors = 20;          // errors collected per source before giving up, 0 for no limit
+};
+
+struct Diagnostic {
+    uint32_t line = 0;   // 1-based, 0 if the error has no source position
+    uint32_t column = 0;
+    uint32_t offset = 0; // byte range of the source the error points at
+    uint32_t length = 0;
+    std::string message;
+};
+
+/**
+ * @brief Errors of one compile, empty if it succeeded
+ */
+struct Diagnostics {
+    std::vector<Diagnostic> errors;
+    std::string text; // formatted as cts prints them, with the source line and a caret
+
+    bool empty() const { return errors.empty(); }
+};
+
+/**
+ * @brief Output of Compiler::compile
+ */
+struct Artifact {
+    std::string code; // textual IR, bitcode, assembly, an object file or a serialized AST
+    Diagnostics diagnostics;
+
+    bool ok() const { return diagnostics.empty(); }
+};
+
+/**
+ * @brief Program compiled to native code in-process by Compiler::load. Its code is released
+ *        when the program is destroyed; the program may outlive the compiler that loaded it.
+ *        Functions take int parameters as int32_t and int[N] parameters as an int32_t* to N
+ *        elements aligned to 16 bytes. An index out of bounds or a division by zero stops a
+ *        call made through runMain or call with an error; through a bare function pointer it
+ *        aborts the process.
+ */
+class Program {
+public:
+    Program(Program&& other) noexcept;
+    Program& operator=(Program&& other) noexcept;
+    ~Program();
+
+    bool ok() const { return library != nullptr; }
+    const Diagnostics& diagnostics() const { return errors; }
+
+    /**
+     * @brief Function to get the address of a function of the program
+     * @param name Function name
+     * @return Address, null if the program has no such function
+     */
+    void* lookup(std::string_view name) const;
+
+    /**
+     * @brief Function to get a function of the program as a typed pointer, e.g. function<int32_t(int32_t)>("f")
+     * @return Function, null if the program has no such function
+     */
+    template <typename Signature>
+    Signature* function(std::string_view name) const {
+        return reinterpret_cast<Signature*>(lookup(name));
+    }
+
+    /**
+     * @brief Function to call a function of the program, e.g. call("f", result, 1, 2)
+     * @param name Function name
+     * @param result Return value of the function
+     * @param arguments int32_t for an int parameter, int32_t* for an int[N] one
+     * @return false if the program has no such function or the call stopped with a runtime
+     *         error, described by runtimeError()
+     */
+    template <typename... Arguments>
+    bool call(std::string_view name, int32_t& result, Arguments... arguments) const {
+        auto target = function<int32_t(Arguments...)>(name);
+        if (!target) {
+            return false;
+        }
+        auto invoke = [&] { result = target(arguments...); };
+        return runChecked([](void* context) { (*static_cast<decltype(invoke)*>(context))(); }, &invoke);
+    }
+
+    /**
+     * @brief Function to call main
+     * @param result Return value of main
+     * @return false if the program has no main or main stopped with a runtime error
+     */
+    bool runMain(int32_t& result) const;
+
+    /**
+     * @brief Function to describe the runtime error the last call stopped with
+     * @return Message, null if the last call returned
+     */
+    const char* runtimeError() const { return failure; }
+
+private:
+    friend class Compiler;
+    Program() = default;
+    void release();
+    bool runChecked(void (*call)(void*), void* context) const;
+
+    std::shared_ptr<llvm::orc::LLJIT> jit; // shared by the programs of a compiler
+    llvm::orc::JITDylib* library = nullptr;
+    Diagnostics errors;
+    mutable const char* failure = nullptr;
+};
+
+/**
+ * @brief Compiles sources held in memory. A compiler keeps its LLVM context, target machine
+ *        and JIT between compiles, so compiling many small sources costs little more than the
+ *        compiles themselves. A compiler is not thread-safe, use one per thread.
+ */
+class Compiler {
+public:
+    explicit Compiler(CompileOptions options = {});
+    ~Compiler();
+
+    Compiler(const Compiler&) = delete;
+    Compiler& operator=(const Compiler&) = delete;
+
+    /**
+     * @brief Function to check a source without generating code
+     * @param source Source text, only read during the call
+     * @return Errors, empty if the source is valid
+     */
+    Diagnostics check(std::string_view source);
+
+    /**
+     * @brief Function to compile a source to an artifact
+     * @param source Source text, only read during the call
+     * @param kind Any kind but EmitKind::Executable, which needs the system linker
+     * @return Artifact, holding the errors if compilation failed
+     */
+    Artifact compile(std::string_view source, EmitKind kind);
+
+    /**
+     * @brief Function to compile a source to native code in this process. LLVM's backend has a
+     *        fixed cost per source of about a millisecond, many small rules load faster as the
+     *        functions of one source than as a source each.
+     * @param source Source text, only read during the call
+     * @return Program, not ok() and holding the errors if compilation failed
+     */
+    Program load(std::string_view source);
+
+private:
+    struct FrontEnd;
+
+    bool runFrontEnd(FrontEnd& frontEnd);
+    bool generate(FrontEnd& frontEnd);
+    llvm::TargetMachine* targetMachine();
+
+    CompileOptions options;
+    std::unique_ptr<CodeGenerator> generator;
+    size_t modulesInContext = 0; // modules generated since the context was created
+    std::unique_ptr<llvm::TargetMachine> host;
+    std::shared_ptr<llvm::orc::LLJIT> jit;
+    uint64_t programsLoaded = 0;
+};
+
+} // namespace nova
+
+#endif // NOVA_H
@@ -0,0 +1,250 @@
+#include "fold.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+class ConstantFolder {
+public:
+    explicit ConstantFolder(const SymbolTable& symbolTable)
+        : symbolTable(symbolTable), known(symbolTable.size()), assigned(symbolTable.size()) {}
+
+    size_t removedCount() const { return removed; }
+
+    void foldFunction(ASTNode* function) {
+        markAssigned(function);
+        foldStatements(function->children);
+    }
+
+private:
+    /**
+     * @brief Function to mark the variables assigned anywhere in a subtree, their let value is not propagated
+     */
+    void markAssigned(const ASTNode* node) {
+        forEachNode(node, [&](const ASTNode* child) {
+            if (child->kind == NodeKind::Assignment && child->children[0]->kind == NodeKind::Variable &&
+                child->children[0]->symbol >= 0) {
+                assigned[child->children[0]->symbol] = true;
+            }
+        }, walk);
+    }
+
+    size_t countNodes(const ASTNode* node) {
+        size_t count = 0;
+        forEachNode(node, [&](const ASTNode*) { ++count; }, walk);
+        return count;
+    }
+
+    void foldStatements(NodeList& statements) {
+        size_t kept = 0;
+        for (ASTNode* statement : statements) {
+            if (!foldStatement(statement, true)) {
+                statements.data[kept++] = statement;
+            } else {
+                removed += countNodes(statement);
+            }
+        }
+        statements.count = kept;
+    }
+
+    /**
+     * @param removable Whether the statement may be dropped, not the case for the initializer of a for loop
+     * @return true if the statement is dead after folding
+     */
+    bool foldStatement(ASTNode* statement, bool removable) {
+        switch (statement->kind) {
+        case NodeKind::VariableDeclaration: {
+            ASTNode* value = statement->children[statement->children.size() - 1];
+            if (value->kind == NodeKind::Type) return false; // an array, zeroed at runtime
+            foldExpression(value);
+            if (value->kind == NodeKind::Literal && statement->symbol >= 0 && !assigned[statement->symbol] &&
+                removable) {
+                // every use is replaced by the constant, the storage is never read
+                known[statement->symbol] = value->number;
+                return true;
+            }
+            return false;
+        }
+        case NodeKind::ReturnStatement:
+        case NodeKind::Call:
+            foldExpression(statement->kind == NodeKind::Call ? statement : statement->children[0]);
+            return false;
+        case NodeKind::Assignment:
+            foldExpression(statement->children[0]);
+            foldExpression(statement->children[1]);
+            return false;
+        case NodeKind::Block:
+            foldStatements(statement->children);
+            return false;
+        case NodeKind::If:
+        case NodeKind::While:
+            foldExpression(statement->children[0]);
+            for (size_t i = 1; i < statement->children.size(); ++i) {
+                foldStatement(statement->children[i], false);
+            }
+            return false;
+        case NodeKind::For:
+            foldStatement(statement->children[0], false);
+            foldExpression(statement->children[1]);
+            foldStatement(statement->children[2], false);
+            foldStatement(statement->children[3], false);
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * @brief Function to fold an expression bottom-up, with an explicit stack so expressions
+     *        of any depth are safe to fold
+     */
+    void foldExpression(ASTNode* expression) {
+        kept.clear();
+        forEachNodePostOrder(expression, [&](ASTNode* node) {
+            // whether each folded child contains a call or may trap, on top of the stack in child order
+            size_t first = kept.size() - node->children.size();
+            uint8_t keep = node->kind == NodeKind::Call;
+            for (size_t i = first; i < kept.size(); ++i) {
+                keep |= kept[i];
+            }
+            // children are folded already, a literal divisor or index is checked at compile time
+            if (node->kind == NodeKind::Index) {
+                keep |= node->children[0]->kind != NodeKind::Literal;
+            } else if (node->kind == NodeKind::BinaryOp && node->value[0] == '/') {
+                keep |= node->children[1]->kind != NodeKind::Literal;
+            }
+            switch (node->kind) {
+            case NodeKind::Variable:
+                if (node->symbol >= 0 && known[node->symbol]) {
+                    makeLiteral(node, *known[node->symbol]);
+                }
+                break;
+            case NodeKind::Index: {
+                ASTNode* index = node->children[0];
+                uint32_t length = symbolTable.getSymbol(node->symbol).length;
+                if (index->kind == NodeKind::Literal && (index->number < 0 || static_cast<uint32_t>(index->number) >= length)) {
+                    handleAnalysisError("Index " + std::to_string(index->number) + " is out of bounds for int[" +
+                                        std::to_string(length) + "]", node->span());
+                }
+                break;
+            }
+            case NodeKind::BinaryOp:
+                foldBinary(node, kept[first], kept[first + 1]);
+                break;
+            default:
+                break;
+            }
+            kept.resize(first);
+            kept.push_back(keep);
+        }, postOrderWalk);
+    }
+
+    /**
+     * @param lhsKept Whether the left operand contains a call or may trap, so it is never dropped
+     * @param rhsKept Whether the right operand contains a call or may trap
+     */
+    void foldBinary(ASTNode* node, bool lhsKept, bool rhsKept) {
+        ASTNode* lhs = node->children[0];
+        ASTNode* rhs = node->children[1];
+        bool lhsConstant = lhs->kind == NodeKind::Literal;
+        bool rhsConstant = rhs->kind == NodeKind::Literal;
+        BinaryOperator op = binaryOperator(node->value);
+
+        if (op == BinaryOperator::Divide && rhsConstant && rhs->number == 0) {
+            handleAnalysisError("Division by zero", node->span());
+        }
+
+        if (lhsConstant && rhsConstant) {
+            makeLiteral(node, evaluate(op, lhs->number, rhs->number));
+            return;
+        }
+
+        // algebraic identities; x*0 drops x, which must not call a function that may write an array
+        // nor divide or index in a way that stops with a runtime error
+        bool add = op == BinaryOperator::Add, subtract = op == BinaryOperator::Subtract;
+        bool multiply = op == BinaryOperator::Multiply, divide = op == BinaryOperator::Divide;
+        if (rhsConstant) {
+            int32_t value = rhs->number;
+            if ((value == 0 && (add || subtract)) || (value == 1 && (multiply || divide))) {
+                replaceWith(node, lhs);
+            } else if (value == 0 && multiply && !lhsKept) {
+                replaceWith(node, rhs);
+            }
+        } else if (lhsConstant) {
+            int32_t value = lhs->number;
+            if ((value == 0 && add) || (value == 1 && multiply)) {
+                replaceWith(node, rhs);
+            } else if (value == 0 && multiply && !rhsKept) {
+                replaceWith(node, lhs);
+            }
+        }
+    }
+
+    static int32_t evaluate(BinaryOperator op, int32_t lhs, int32_t rhs) {
+        // wrap like the i32 instructions codegen emits instead of overflowing
+        uint32_t a = static_cast<uint32_t>(lhs), b = static_cast<uint32_t>(rhs);
+        switch (op) {
+        case BinaryOperator::Add: return static_cast<int32_t>(a + b);
+        case BinaryOperator::Subtract: return static_cast<int32_t>(a - b);
+        case BinaryOperator::Multiply: return static_cast<int32_t>(a * b);
+        // INT_MIN / -1 wraps to INT_MIN, as in generated code and the interpreter
+        case BinaryOperator::Divide: return rhs == -1 ? static_cast<int32_t>(0u - a) : lhs / rhs;
+        case BinaryOperator::Less: return lhs < rhs;
+        case BinaryOperator::LessEqual: return lhs <= rhs;
+        case BinaryOperator::Greater: return lhs > rhs;
+        case BinaryOperator::GreaterEqual: return lhs >= rhs;
+        case BinaryOperator::Equal: return lhs == rhs;
+        case BinaryOperator::NotEqual: return lhs != rhs;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Function to turn a variable, or an operation over two literals, into a literal
+     */
+    void makeLiteral(ASTNode* node, int32_t value) {
+        removed += node->children.size();
+        node->kind = NodeKind::Literal;
+        node->value = {};
+        node->children = {};
+        node->symbol = -1;
+        node->number = value;
+    }
+
+    /**
+     * @brief Function to replace an operation by one of its operands, dropping the other one
+     */
+    void replaceWith(ASTNode* node, ASTNode* operand) {
+        ASTNode* dropped = node->children[0] == operand ? node->children[1] : node->children[0];
+        removed += 1 + countNodes(dropped);
+        *node = *operand;
+    }
+
+    const SymbolTable& symbolTable;
+    std::vector<std::optional<int32_t>> known; // constant value per symbol slot
+    std::vector<bool> assigned;                // per symbol slot, reassigned somewhere in the function
+    std::vector<uint8_t> kept;                 // per folded subtree of foldExpression, whether it contains a call
+                                               // or may stop with a runtime error, so it is never dropped
+    PostOrderStack<ASTNode> postOrderWalk;     // scratch stacks of the tree walks, reused across walks
+    std::vector<const ASTNode*> walk;
+    size_t removed = 0;                        // nodes dropped from the tree so far
+};
+
+} // namespace
+
+size_t foldConstants(ASTNode* ast, const SymbolTable& symbolTable) {
+    if (!ast) {
+        return 0;
+    }
+    ConstantFolder folder(symbolTable);
+    if (ast->kind == NodeKind::Program) {
+        for (ASTNode* function : ast->children) {
+            folder.foldFunction(function);
+        }
+    } else if (ast->kind == NodeKind::Function) {
+        folder.foldFunction(ast);
+    }
+    return folder.removedCount();
+}
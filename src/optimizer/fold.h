@@ -0,0 +1,19 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "../parser/parser.h"
+#include "../analysis/analysis.h"
+
+/**
+ * @brief Function to fold constants in resolved functions before code generation.
+ *        Folds BinaryOp subtrees over int (wrapping 32-bit, like the generated code),
+ *        propagates the values of lets that fold to a constant and are never assigned
+ *        into their uses and drops those declarations, and applies x+0, x-0, x*1, x/1 and x*0.
+ * @param ast Program or Function node, resolved by semanticAnalysis; rewritten in place
+ * @param symbolTable Table the function was resolved against
+ * @return Number of nodes removed from the tree
+ * @throws CompileError on division by a constant zero or a constant index out of an array's bounds
+ */
+size_t foldConstants(ASTNode* ast, const SymbolTable& symbolTable);
+
+#endif // FOLD_H
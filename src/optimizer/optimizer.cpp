@@ -0,0 +1,93 @@
+#include "optimizer.h"
+#include "../logger/logger.h"
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/IR/PassTimingInfo.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar/EarlyCSE.h>
+#include <llvm/Transforms/Scalar/SROA.h>
+#include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <chrono>
+#include <vector>
+
+static llvm::OptimizationLevel toLLVMLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::OptimizationLevel::O0;
+        case OptLevel::O1: return llvm::OptimizationLevel::O1;
+        case OptLevel::O2: return llvm::OptimizationLevel::O2;
+        case OptLevel::O3: return llvm::OptimizationLevel::O3;
+    }
+    return llvm::OptimizationLevel::O0;
+}
+
+void optimizeModule(llvm::Module& module, OptLevel level, llvm::TargetMachine* targetMachine, bool timePasses) {
+    auto start = std::chrono::steady_clock::now();
+
+    llvm::PassInstrumentationCallbacks callbacks;
+    llvm::TimePassesHandler passTimer(timePasses);
+    if (timePasses) {
+        passTimer.setOutStream(llvm::errs());
+        passTimer.registerCallbacks(callbacks);
+    }
+
+    llvm::LoopAnalysisManager loopAnalysis;
+    llvm::FunctionAnalysisManager functionAnalysis;
+    llvm::CGSCCAnalysisManager cgsccAnalysis;
+    llvm::ModuleAnalysisManager moduleAnalysis;
+
+    llvm::PassBuilder passBuilder(targetMachine, llvm::PipelineTuningOptions(), llvm::None, &callbacks);
+    passBuilder.registerModuleAnalyses(moduleAnalysis);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysis);
+    passBuilder.registerFunctionAnalyses(functionAnalysis);
+    passBuilder.registerLoopAnalyses(loopAnalysis);
+    passBuilder.crossRegisterProxies(loopAnalysis, functionAnalysis, cgsccAnalysis, moduleAnalysis);
+
+    llvm::ModulePassManager passes = level == OptLevel::O0
+        ? passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0)
+        : passBuilder.buildPerModuleDefaultPipeline(toLLVMLevel(level));
+    passes.run(module, moduleAnalysis);
+
+    if (timePasses) {
+        passTimer.print();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        log::info("Optimization pipeline took {} ms", elapsed);
+    }
+}
+
+void cleanupFunctions(llvm::Module& module, OptLevel level) {
+    std::vector<llvm::Function*> definitions;
+    for (llvm::Function& function : module) {
+        if (!function.isDeclaration()) {
+            definitions.push_back(&function);
+        }
+    }
+    cleanupFunctions(definitions, level);
+}
+
+void cleanupFunctions(llvm::ArrayRef<llvm::Function*> functions, OptLevel level) {
+    if (functions.empty() || level == OptLevel::O0) {
+        return;
+    }
+
+    llvm::LoopAnalysisManager loopAnalysis;
+    llvm::FunctionAnalysisManager functionAnalysis;
+    llvm::CGSCCAnalysisManager cgsccAnalysis;
+    llvm::ModuleAnalysisManager moduleAnalysis;
+
+    llvm::PassBuilder passBuilder;
+    passBuilder.registerModuleAnalyses(moduleAnalysis);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysis);
+    passBuilder.registerFunctionAnalyses(functionAnalysis);
+    passBuilder.registerLoopAnalyses(loopAnalysis);
+    passBuilder.crossRegisterProxies(loopAnalysis, functionAnalysis, cgsccAnalysis, moduleAnalysis);
+
+    llvm::FunctionPassManager passes;
+    passes.addPass(llvm::SROAPass());
+    passes.addPass(llvm::EarlyCSEPass(true));
+    passes.addPass(llvm::InstCombinePass());
+    passes.addPass(llvm::SimplifyCFGPass());
+    for (llvm::Function* function : functions) {
+        passes.run(*function, functionAnalysis);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+enum class OptLevel {
+    O0,
+    O1,
+    O2,
+    O3
+};
+
+/**
+ * @brief Function to run the default new-PassManager pipeline for a level
+ * @param module Module to optimize in place
+ * @param level Optimization level, O0 only runs always-inline
+ * @param targetMachine Target used for cost models, may be null
+ * @param timePasses Print per-pass timings to stderr when done
+ */
+void optimizeModule(llvm::Module& module, OptLevel level, llvm::TargetMachine* targetMachine, bool timePasses);
+
+/**
+ * @brief Function to run the function-local cleanup the module pipeline starts with (SROA,
+ *        early CSE, instcombine, CFG simplification). Every function is cleaned up on its own,
+ *        so the result does not depend on which other functions share the module.
+ * @param module Module to clean up in place
+ * @param level Optimization level, nothing runs at O0
+ */
+void cleanupFunctions(llvm::Module& module, OptLevel level);
+
+/**
+ * @brief Function to run the same cleanup on some functions only
+ * @param functions Function definitions to clean up in place
+ * @param level Optimization level, nothing runs at O0
+ */
+void cleanupFunctions(llvm::ArrayRef<llvm::Function*> functions, OptLevel level);
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,101 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Bump allocator that owns every object allocated from it. Objects
+ *        are never destroyed individually, the whole arena is released at once.
+ *        Blocks grow geometrically so a compile costs O(log n) mallocs.
+ */
+class Arena {
+public:
+    explicit Arena(size_t initialBlockSize = 16 * 1024) : nextBlockSize(initialBlockSize) {}
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @brief Function to allocate raw memory
+     * @param size Number of bytes
+     * @param align Required alignment, must be a power of two
+     * @return Pointer to uninitialized memory owned by the arena
+     */
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (!head || offset + size > head->size) {
+            grow(size + align);
+            offset = (used + align - 1) & ~(align - 1);
+        }
+        used = offset + size;
+        allocatedBytes += size;
+        return head->data() + offset;
+    }
+
+    /**
+     * @brief Function to construct an object inside the arena
+     * @return Pointer to the new object, valid until the arena is destroyed
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arena objects are never destroyed, T must be trivially destructible");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Function to allocate an uninitialized array inside the arena
+     * @param count Number of elements
+     */
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arena objects are never destroyed, T must be trivially destructible");
+        if (count == 0) return nullptr;
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /**
+     * @brief Function to get the number of bytes handed out so far
+     */
+    size_t bytesAllocated() const { return allocatedBytes; }
+
+private:
+    struct Block {
+        Block* previous;
+        size_t size;
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    void grow(size_t minimum) {
+        size_t size = nextBlockSize;
+        while (size < minimum) size *= 2;
+        nextBlockSize = size * 2;
+
+        void* memory = std::malloc(sizeof(Block) + size);
+        if (!memory) throw std::bad_alloc();
+        head = new (memory) Block{head, size};
+        used = 0;
+    }
+
+    void release() {
+        while (head) {
+            Block* previous = head->previous;
+            std::free(head);
+            head = previous;
+        }
+        used = 0;
+    }
+
+    Block* head = nullptr;
+    size_t used = 0;
+    size_t nextBlockSize;
+    size_t allocatedBytes = 0;
+};
+
+#endif // ARENA_H
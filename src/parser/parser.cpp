@@ -1,37 +1,161 @@
 #include "parser.h"
+#include <algorithm>
+#include <charconv>
 
-void handleError(const std::string& message) {
-    std::cerr << "Parsing Error: " << message << std::endl;
-    std::exit(1);
+void handleError(const std::string& message, SourceSpan span) {
+    throw CompileError(message, span);
+}
+
+const char* nodeKindName(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::Program: return "Program";
+        case NodeKind::Function: return "Function";
+        case NodeKind::Parameter: return "Parameter";
+        case NodeKind::VariableDeclaration: return "VariableDeclaration";
+        case NodeKind::Type: return "Type";
+        case NodeKind::ReturnStatement: return "ReturnStatement";
+        case NodeKind::BinaryOp: return "BinaryOp";
+        case NodeKind::Literal: return "Literal";
+        case NodeKind::Variable: return "Variable";
+        case NodeKind::Call: return "Call";
+        case NodeKind::Index: return "Index";
+        case NodeKind::Assignment: return "Assignment";
+        case NodeKind::Block: return "Block";
+        case NodeKind::If: return "If";
+        case NodeKind::While: return "While";
+        case NodeKind::For: return "For";
+    }
+    return "Unknown";
+}
+
+BinaryOperator binaryOperator(std::string_view op) {
+    switch (op[0]) {
+        case '+': return BinaryOperator::Add;
+        case '-': return BinaryOperator::Subtract;
+        case '*': return BinaryOperator::Multiply;
+        case '/': return BinaryOperator::Divide;
+        case '<': return op.size() == 1 ? BinaryOperator::Less : BinaryOperator::LessEqual;
+        case '>': return op.size() == 1 ? BinaryOperator::Greater : BinaryOperator::GreaterEqual;
+        case '=': return BinaryOperator::Equal;
+        default: return BinaryOperator::NotEqual;
+    }
 }
 
 void printAST(const ASTNode* node, int depth) {
-    for (int i = 0; i < depth; ++i) std::cout << "  ";
-    std::cout << node->type << (node->value.empty() ? "" : ": " + node->value) << std::endl;
-    for (const auto& child : node->children) {
-        printAST(child, depth + 1);
+    std::vector<std::pair<const ASTNode*, int>> stack{{node, depth}};
+    while (!stack.empty()) {
+        auto [current, level] = stack.back();
+        stack.pop_back();
+        for (int i = 0; i < level; ++i) std::cout << "  ";
+        std::cout << nodeKindName(current->kind);
+        if (current->kind == NodeKind::Literal) std::cout << ": " << current->number; // folded literals have no source text
+        else if (!current->value.empty()) std::cout << ": " << current->value;
+        if (current->kind == NodeKind::Type && current->number > 0) std::cout << "[" << current->number << "]";
+        std::cout << '\n';
+        for (size_t i = current->children.size(); i-- > 0;) {
+            stack.emplace_back(current->children[i], level + 1);
+        }
     }
+    std::cout.flush();
 }
 
 
 
-Token Parser::peek() {
-    return index < tokens.size() ? tokens[index] : Token{TokenType::UNKNOWN, "", -1, -1};
+/**
+ * @brief Function to describe a token in an error message, its position is printed separately
+ */
+static std::string describe(const Token& token) {
+    if (token.type == TokenType::END_OF_FILE) return "end of input";
+    return "'" + std::string(token.value) + "'";
 }
 
-Token Parser::consume() {
-    return index < tokens.size() ? tokens[index++] : Token{TokenType::UNKNOWN, "", -1, -1};
+SourceSpan Parser::spanOf(const Token& token) const {
+    return {static_cast<uint32_t>(token.value.data() - lexer.source().data()), static_cast<uint32_t>(token.value.size())};
 }
 
-void Parser::expect(TokenType type, const std::string& value) {
-    Token token = consume();
+void Parser::expect(TokenType type, std::string_view value) {
+    // left in place on a mismatch, it may start the construct recovery resumes at
+    const Token& token = peek();
     if (token.type != type || (!value.empty() && token.value != value)) {
-        handleError("Unexpected token: " + token.to_string());
+        handleError("Expected '" + std::string(value) + "', got " + describe(token), spanOf(token));
+    }
+    consume();
+}
+
+ASTNode* Parser::makeNode(NodeKind kind, std::string_view value, std::initializer_list<ASTNode*> children) {
+    ASTNode* node = arena.make<ASTNode>(kind, value);
+    std::string_view source = lexer.source();
+    if (value.data() >= source.data() && value.data() <= source.data() + source.size()) {
+        node->offset = static_cast<uint32_t>(value.data() - source.data());
+    }
+    ++nodes;
+    if (children.size()) {
+        node->children.data = arena.allocateArray<ASTNode*>(children.size());
+        node->children.count = 0;
+        for (ASTNode* child : children) {
+            node->children.data[node->children.count++] = child;
+        }
+    }
+    return node;
+}
+
+ASTNode* Parser::makeLiteral(const Token& token) {
+    ASTNode* node = makeNode(NodeKind::Literal, token.value);
+    auto [end, error] = std::from_chars(token.value.data(), token.value.data() + token.value.size(), node->number);
+    if (error != std::errc() || end != token.value.data() + token.value.size()) {
+        handleError("Integer literal out of range: " + describe(token), spanOf(token));
+    }
+    return node;
+}
+
+NodeList Parser::takePending(size_t mark) {
+    NodeList list;
+    list.count = pending.size() - mark;
+    list.data = arena.allocateArray<ASTNode*>(list.count);
+    std::copy(pending.begin() + mark, pending.end(), list.data);
+    pending.resize(mark);
+    return list;
+}
+
+void Parser::synchronizeStatement() {
+    // a block the bad statement opened is skipped as a whole, its '}' ends the statement
+    size_t depth = 0;
+    while (true) {
+        const Token& token = peek();
+        if (token.type == TokenType::END_OF_FILE) return;
+        if (token.type == TokenType::KEYWORD && token.value == "fn") return;
+        bool symbol = token.type == TokenType::SYMBOL;
+        if (symbol && token.value == "}" && depth == 0) return;
+        bool ends = symbol && ((token.value == ";" && depth == 0) || (token.value == "}" && depth == 1));
+        if (symbol && token.value == "{") ++depth;
+        if (symbol && token.value == "}") --depth;
+        consume();
+        if (ends) return;
+    }
+}
+
+void Parser::synchronizeFunction() {
+    while (peek().type != TokenType::END_OF_FILE && (peek().type != TokenType::KEYWORD || peek().value != "fn")) {
+        consume();
     }
 }
 
 ASTNode* Parser::parse() {
-    return parseFunction();
+    ASTNode* program = makeNode(NodeKind::Program, "");
+    size_t mark = pending.size();
+    do {
+        size_t functionMark = pending.size();
+        try {
+            ASTNode* function = parseFunction();
+            pending.push_back(function);
+        } catch (const CompileError& error) {
+            diagnostics.recover(error);
+            pending.resize(functionMark);
+            synchronizeFunction();
+        }
+    } while (peek().type != TokenType::END_OF_FILE);
+    program->children = takePending(mark);
+    return program;
 }
 
 ASTNode* Parser::parseFunction() {
@@ -39,57 +163,221 @@ ASTNode* Parser::parseFunction() {
 
     Token name = consume();
     if (name.type != TokenType::IDENTIFIER) {
-        handleError("Expected function name, got: " + name.to_string());
+        handleError("Expected function name, got " + describe(name), spanOf(name));
     }
 
+    ASTNode* funcNode = makeNode(NodeKind::Function, name.value);
+    size_t mark = pending.size();
+
+    // parameters come first among the children, followed by the statements
     expect(TokenType::SYMBOL, "(");
+    if (peek().type != TokenType::SYMBOL || peek().value != ")") {
+        while (true) {
+            pending.push_back(parseParameter());
+            if (peek().type != TokenType::SYMBOL || peek().value != ",") break;
+            consume(); // Consume ','
+        }
+    }
     expect(TokenType::SYMBOL, ")");
     expect(TokenType::SYMBOL, "{");
 
-    ASTNode* funcNode = new ASTNode("Function", name.value);
+    NodeList statements = parseStatements();
+    pending.insert(pending.end(), statements.begin(), statements.end());
+    funcNode->children = takePending(mark);
 
-    while (peek().type != TokenType::SYMBOL || peek().value != "}") {
-        funcNode->children.push_back(parseStatement());
+    expect(TokenType::SYMBOL, "}");
+    return funcNode;
+}
+
+NodeList Parser::parseStatements() {
+    size_t mark = pending.size();
+    // a statement with a syntax error is dropped, parsing resumes after its ';'
+    while (!nextIsSymbol("}") && peek().type != TokenType::END_OF_FILE &&
+           (peek().type != TokenType::KEYWORD || peek().value != "fn")) {
+        size_t statementMark = pending.size();
+        try {
+            ASTNode* statement = parseStatement();
+            pending.push_back(statement);
+        } catch (const CompileError& error) {
+            diagnostics.recover(error);
+            pending.resize(statementMark);
+            synchronizeStatement();
+        }
     }
+    return takePending(mark);
+}
+
+Parser::NestingGuard::NestingGuard(Parser& parser, const Token& token) : parser(parser) {
+    if (parser.nesting >= MAX_NESTING_DEPTH) {
+        handleError("Statements nested more than " + std::to_string(MAX_NESTING_DEPTH) + " deep", parser.spanOf(token));
+    }
+    ++parser.nesting;
+}
 
+ASTNode* Parser::parseBlock() {
+    NestingGuard guard(*this, peek());
+    uint32_t offset = spanOf(peek()).offset;
+    expect(TokenType::SYMBOL, "{");
+    ASTNode* block = makeNode(NodeKind::Block, "");
+    block->offset = offset;
+    block->children = parseStatements();
     expect(TokenType::SYMBOL, "}");
-    return funcNode;
+    return block;
 }
 
-ASTNode* Parser::parseStatement() {
-    Token token = peek();
+ASTNode* Parser::parseParameter() {
+    Token name = consume();
+    if (name.type != TokenType::IDENTIFIER) {
+        handleError("Expected parameter name, got " + describe(name), spanOf(name));
+    }
+    expect(TokenType::SYMBOL, ":");
+    return makeNode(NodeKind::Parameter, name.value, {parseType()});
+}
 
-    if (token.type == TokenType::KEYWORD && token.value == "return") {
-        return parseReturnStatement();
+ASTNode* Parser::parseType() {
+    const Token& type = consume();
+    if (type.type != TokenType::KEYWORD) {
+        handleError("Expected type, got " + describe(type), spanOf(type));
+    }
+    ASTNode* typeNode = makeNode(NodeKind::Type, type.value);
+    if (nextIsSymbol("[")) {
+        consume(); // Consume '['
+        const Token& length = consume();
+        if (length.type != TokenType::NUMBER) {
+            handleError("Expected array length, got " + describe(length), spanOf(length));
+        }
+        typeNode->number = makeLiteral(length)->number;
+        if (typeNode->number <= 0 || typeNode->number > MAX_ARRAY_LENGTH) {
+            handleError("Array length must be between 1 and " + std::to_string(MAX_ARRAY_LENGTH) + ", got " +
+                        describe(length), spanOf(length));
+        }
+        expect(TokenType::SYMBOL, "]");
+    }
+    return typeNode;
+}
+
+ASTNode* Parser::parseStatement() {
+    const Token& token = peek();
+
+    if (token.type == TokenType::KEYWORD) {
+        if (token.value == "return") return parseReturnStatement();
+        if (token.value == "let") return parseVariableDeclaration();
+        if (token.value == "if") return parseIf();
+        if (token.value == "while") return parseWhile();
+        if (token.value == "for") return parseFor();
     }
 
-    if (token.type == TokenType::KEYWORD && token.value == "let") {
-        return parseVariableDeclaration();
+    if (token.type == TokenType::IDENTIFIER) {
+        // a call is evaluated for its effect on the arrays passed to it
+        if (lexer.peek(1).type == TokenType::SYMBOL && lexer.peek(1).value == "(") {
+            ASTNode* call = parseCall();
+            expect(TokenType::SYMBOL, ";");
+            return call;
+        }
+        return parseAssignment(true);
     }
 
-    handleError("Unknown statement: " + token.to_string());
+    handleError("Unknown statement starting with " + describe(token), spanOf(token));
     return nullptr;
 }
 
+ASTNode* Parser::parseAssignment(bool terminated) {
+    const Token& name = peek();
+    if (name.type != TokenType::IDENTIFIER) {
+        handleError("Expected variable name, got " + describe(name), spanOf(name));
+    }
+    // a Variable or an Index, the name is followed by '[' or '='
+    std::string_view targetName = consume().value;
+    ASTNode* target;
+    if (nextIsSymbol("[")) {
+        consume(); // Consume '['
+        ASTNode* index = parseExpression();
+        expect(TokenType::SYMBOL, "]");
+        target = makeNode(NodeKind::Index, targetName, {index});
+    } else {
+        target = makeNode(NodeKind::Variable, targetName);
+    }
+
+    Token op = peek(); // copied, the span is needed after the value is parsed
+    expect(TokenType::SYMBOL, "=");
+    ASTNode* value = parseExpression();
+    if (terminated) {
+        expect(TokenType::SYMBOL, ";");
+    }
+    return makeNode(NodeKind::Assignment, op.value, {target, value});
+}
+
+ASTNode* Parser::parseIf() {
+    NestingGuard guard(*this, peek());
+    uint32_t offset = spanOf(peek()).offset;
+    expect(TokenType::KEYWORD, "if");
+    expect(TokenType::SYMBOL, "(");
+    ASTNode* condition = parseExpression();
+    expect(TokenType::SYMBOL, ")");
+    ASTNode* then = parseBlock();
+
+    ASTNode* node;
+    if (peek().type == TokenType::KEYWORD && peek().value == "else") {
+        consume(); // Consume 'else'
+        bool chained = peek().type == TokenType::KEYWORD && peek().value == "if";
+        ASTNode* otherwise = chained ? parseIf() : parseBlock();
+        node = makeNode(NodeKind::If, "", {condition, then, otherwise});
+    } else {
+        node = makeNode(NodeKind::If, "", {condition, then});
+    }
+    node->offset = offset;
+    return node;
+}
+
+ASTNode* Parser::parseWhile() {
+    NestingGuard guard(*this, peek());
+    uint32_t offset = spanOf(peek()).offset;
+    expect(TokenType::KEYWORD, "while");
+    expect(TokenType::SYMBOL, "(");
+    ASTNode* condition = parseExpression();
+    expect(TokenType::SYMBOL, ")");
+    ASTNode* node = makeNode(NodeKind::While, "", {condition, parseBlock()});
+    node->offset = offset;
+    return node;
+}
+
+ASTNode* Parser::parseFor() {
+    NestingGuard guard(*this, peek());
+    uint32_t offset = spanOf(peek()).offset;
+    expect(TokenType::KEYWORD, "for");
+    expect(TokenType::SYMBOL, "(");
+    // both forms of the initializer consume the ';' after it
+    bool declaration = peek().type == TokenType::KEYWORD && peek().value == "let";
+    ASTNode* init = declaration ? parseVariableDeclaration() : parseAssignment(true);
+    ASTNode* condition = parseExpression();
+    expect(TokenType::SYMBOL, ";");
+    ASTNode* step = parseAssignment(false);
+    expect(TokenType::SYMBOL, ")");
+    ASTNode* node = makeNode(NodeKind::For, "", {init, condition, step, parseBlock()});
+    node->offset = offset;
+    return node;
+}
+
 ASTNode* Parser::parseVariableDeclaration() {
     log::debug("Parsing variable declaration");
     expect(TokenType::KEYWORD, "let");
 
     Token name = consume();
     if (name.type != TokenType::IDENTIFIER) {
-        handleError("Expected variable name, got: " + name.to_string());
+        handleError("Expected variable name, got " + describe(name), spanOf(name));
     }
 
     // Optional type declaration
-    Token next = peek();
     ASTNode* typeNode = nullptr;
-    if (next.type == TokenType::SYMBOL && next.value == ":") {
+    if (nextIsSymbol(":")) {
         consume(); // Consume ':'
-        Token type = consume();
-        if (type.type != TokenType::KEYWORD) {
-            handleError("Expected type, got: " + type.to_string());
-        }
-        typeNode = new ASTNode("Type", type.value);
+        typeNode = parseType();
+    }
+
+    // an array starts out zeroed and has no initializer
+    if (typeNode && typeNode->number > 0) {
+        expect(TokenType::SYMBOL, ";");
+        return makeNode(NodeKind::VariableDeclaration, name.value, {typeNode});
     }
 
     expect(TokenType::SYMBOL, "=");
@@ -98,102 +386,143 @@ ASTNode* Parser::parseVariableDeclaration() {
 
     expect(TokenType::SYMBOL, ";"); // Ensure semicolon at the end
 
-    ASTNode* varNode = new ASTNode("VariableDeclaration", name.value);
     if (typeNode) {
-        varNode->children.push_back(typeNode); // Add type if declared
+        return makeNode(NodeKind::VariableDeclaration, name.value, {typeNode, value}); // Add type if declared
     }
-    varNode->children.push_back(value);
-    return varNode;
+    return makeNode(NodeKind::VariableDeclaration, name.value, {value});
 }
 
 
 
-int getPrecedence(const std::string& op) {
-    if (op == "+" || op == "-") return 1; // Lower precedence
-    if (op == "*" || op == "/") return 2; // Higher precedence
+int getPrecedence(std::string_view op) {
+    if (op == "==" || op == "!=") return 1; // Lowest precedence
+    if (op == "<" || op == "<=" || op == ">" || op == ">=") return 2;
+    if (op == "+" || op == "-") return 3;
+    if (op == "*" || op == "/") return 4; // Highest precedence
     return 0; // Invalid operator
 }
 
-ASTNode* Parser::parsePrimary() {
-    Token token = peek();
+void Parser::reduceOperator() {
+    PendingOperator top = operators.back();
+    operators.pop_back();
+    ASTNode* right = pending.back();
+    pending.pop_back();
+    pending.back() = makeNode(NodeKind::BinaryOp, top.op, {pending.back(), right});
+}
 
-    // Handle parentheses
-    if (token.type == TokenType::SYMBOL && token.value == "(") {
-        consume(); // Consume '('
-        ASTNode* expr = parseExpression(); // Parse the inner expression
-        expect(TokenType::SYMBOL, ")"); // Ensure closing ')'
-        return expr;
-    }
+ASTNode* Parser::parseCall() {
+    Token callee = consume();
+    expect(TokenType::SYMBOL, "(");
 
-    // Handle literals and variables
-    Token lhs = consume();
-    if (lhs.type == TokenType::IDENTIFIER || lhs.type == TokenType::NUMBER) {
-        return new ASTNode(lhs.type == TokenType::IDENTIFIER ? "Variable" : "Literal", lhs.value);
+    ASTNode* call = makeNode(NodeKind::Call, callee.value);
+    size_t mark = pending.size();
+    if (peek().type != TokenType::SYMBOL || peek().value != ")") {
+        while (true) {
+            ASTNode* argument = parseExpression();
+            pending.push_back(argument);
+            if (peek().type != TokenType::SYMBOL || peek().value != ",") break;
+            consume(); // Consume ','
+        }
     }
-
-    handleError("Expected identifier, number, or parenthesis, got: " + lhs.to_string());
-    return nullptr;
+    expect(TokenType::SYMBOL, ")");
+    call->children = takePending(mark);
+    return call;
 }
 
-
-ASTNode* Parser::parseBinaryOpRHS(int exprPrecedence, ASTNode* left) {
+ASTNode* Parser::parseExpression() {
+    // not reentrant, nested expressions are groups on the stacks rather than calls
+    size_t base = pending.size();
+    operators.clear();
+    groups.clear();
+    bool expectOperand = true;
     while (true) {
-        Token op = peek();
-
-        // Stop parsing if the token is not an operator or indicates the end of an expression
-        if (op.type == TokenType::SYMBOL && op.value == ";") return left; // End of statement
-        if (op.type == TokenType::KEYWORD && op.value == "let") return left; // Start of a new statement
-        if (op.type != TokenType::SYMBOL || getPrecedence(op.value) == 0) return left; // Non-operator
-
-        int tokenPrecedence = getPrecedence(op.value);
-
-        // Stop parsing if the current operator has lower precedence
-        if (tokenPrecedence < exprPrecedence) {
-            return left;
+        if (expectOperand) {
+            const Token& token = peek();
+            if (token.type == TokenType::SYMBOL && token.value == "(") {
+                consume(); // Consume '('
+                groups.push_back({nullptr, pending.size(), operators.size()});
+                continue;
+            }
+            bool identifier = token.type == TokenType::IDENTIFIER;
+            const Token& following = identifier ? lexer.peek(1) : token;
+            if (identifier && following.type == TokenType::SYMBOL && (following.value == "(" || following.value == "[")) {
+                bool call = following.value == "(";
+                std::string_view name = consume().value;
+                consume(); // Consume '(' or '['
+                ASTNode* node = makeNode(call ? NodeKind::Call : NodeKind::Index, name);
+                if (call && nextIsSymbol(")")) {
+                    consume(); // Consume ')'
+                    node->children = takePending(pending.size());
+                    pending.push_back(node);
+                    expectOperand = false;
+                    continue;
+                }
+                groups.push_back({node, pending.size(), operators.size()});
+                continue;
+            }
+            // a bad token is left in place, it may be the ';' or '}' recovery resumes at
+            if (token.type != TokenType::IDENTIFIER && token.type != TokenType::NUMBER) {
+                handleError("Expected identifier, number, or parenthesis, got " + describe(token), spanOf(token));
+            }
+            const Token& operand = consume();
+            if (operand.type == TokenType::IDENTIFIER) {
+                pending.push_back(makeNode(NodeKind::Variable, operand.value));
+            } else {
+                pending.push_back(makeLiteral(operand));
+            }
+            expectOperand = false;
+            continue;
         }
 
-        consume(); // Consume the operator
-
-        // Parse the next primary expression
-        ASTNode* right = parsePrimary();
-
-        // Check if the next operator has higher precedence
-        Token nextOp = peek();
-        int nextPrecedence = getPrecedence(nextOp.value);
-        if (tokenPrecedence < nextPrecedence) {
-            right = parseBinaryOpRHS(tokenPrecedence + 1, right);
+        // operators of equal precedence associate to the left, so those already pending are applied first
+        size_t operatorMark = groups.empty() ? 0 : groups.back().operatorMark;
+        const Token& op = peek();
+        int precedence = op.type == TokenType::SYMBOL ? getPrecedence(op.value) : 0;
+        if (precedence > 0) {
+            while (operators.size() > operatorMark && operators.back().precedence >= precedence) {
+                reduceOperator();
+            }
+            operators.push_back({consume().value, precedence});
+            expectOperand = true;
+            continue;
         }
 
-        // Create a new BinaryOp node
-        ASTNode* opNode = new ASTNode("BinaryOp", op.value);
-        opNode->children.push_back(left);
-        opNode->children.push_back(right);
-        left = opNode;
+        // anything else ends the operand of the innermost group, or the whole expression
+        while (operators.size() > operatorMark) {
+            reduceOperator();
+        }
+        if (groups.empty()) break;
+        OpenGroup group = groups.back();
+        if (!group.node) {
+            expect(TokenType::SYMBOL, ")");
+        } else if (group.node->kind == NodeKind::Index) {
+            expect(TokenType::SYMBOL, "]");
+            group.node->children = takePending(group.operandMark);
+            pending.push_back(group.node);
+        } else if (nextIsSymbol(",")) {
+            consume(); // Consume ',', the argument stays on the operand stack
+            expectOperand = true;
+            continue;
+        } else {
+            expect(TokenType::SYMBOL, ")");
+            group.node->children = takePending(group.operandMark);
+            pending.push_back(group.node);
+        }
+        groups.pop_back();
     }
+    ASTNode* expression = pending[base];
+    pending.resize(base);
+    return expression;
 }
 
-ASTNode* Parser::parseExpression() {
-    ASTNode* left = parsePrimary(); // Parse the left-hand side
-    return parseBinaryOpRHS(0, left); // Process the rest based on precedence
-}
-
-
-
 ASTNode* Parser::parseReturnStatement() {
+    uint32_t offset = spanOf(peek()).offset;
     expect(TokenType::KEYWORD, "return");
 
-    Token value = consume();
-    if (value.type != TokenType::NUMBER && value.type != TokenType::IDENTIFIER) {
-        handleError("Expected value after return, got: " + value.to_string());
-    }
-
+    ASTNode* value = parseExpression();
     expect(TokenType::SYMBOL, ";");
 
-    ASTNode* returnNode = new ASTNode("ReturnStatement", "");
-    if (value.type == TokenType::NUMBER) {
-        returnNode->children.push_back(new ASTNode("Literal", value.value));
-    } else if (value.type == TokenType::IDENTIFIER) {
-        returnNode->children.push_back(new ASTNode("Variable", value.value));
-    }
-    return returnNode;
+    ASTNode* node = makeNode(NodeKind::ReturnStatement, "", {value});
+    node->offset = offset;
+    return node;
 }
\ No newline at end of file
@@ -1,79 +1,343 @@
 #include <vector>
+#include <utility>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <stdexcept>
+#include <initializer_list>
 #include "../tokenizer/tokenize.h"
 #include "../logger/logger.h"
+#include "../diagnostics/diagnostics.h"
+#include "arena.h"
 #ifndef PARSER_H
 #define PARSER_H
 
+enum class NodeKind {
+    Program,
+    Function,
+    Parameter,
+    VariableDeclaration,
+    Type,
+    ReturnStatement,
+    BinaryOp,
+    Literal,
+    Variable,
+    Call,
+    Index,       // value is the array name, the child is the index
+    Assignment,  // target (Variable or Index), then the value
+    Block,
+    If,          // condition, then block, optional else block or If
+    While,       // condition, body block
+    For          // initializer, condition, step assignment, body block
+};
+
+// arrays live on the stack, bounded well below the default 8 MB
+constexpr int32_t MAX_ARRAY_LENGTH = 1 << 20;
+
+// statements are walked recursively, so blocks and control statements (an else if chain
+// counts each link) nest at most this deep; expressions are walked with explicit stacks and
+// may nest arbitrarily deep
+constexpr uint32_t MAX_NESTING_DEPTH = 1000;
+
+enum class BinaryOperator {
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual
+};
+
+/**
+ * @brief Function to get the operator of a BinaryOp node
+ * @param op Operator text, one the parser accepts
+ * @return BinaryOperator
+ */
+BinaryOperator binaryOperator(std::string_view op);
+
+/**
+ * @brief Function to check whether an operator is a comparison, which yields 0 or 1
+ */
+inline bool isComparison(BinaryOperator op) {
+    return op >= BinaryOperator::Less;
+}
+
+/**
+ * @brief Function to get the printable name of a node kind
+ * @param kind Node kind
+ * @return Name as used in AST dumps
+ */
+const char* nodeKindName(NodeKind kind);
+
+struct ASTNode;
+
+/**
+ * @brief Contiguous, arena-owned slice of child pointers
+ */
+struct NodeList {
+    ASTNode** data = nullptr;
+    size_t count = 0;
+
+    ASTNode** begin() const { return data; }
+    ASTNode** end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    ASTNode* operator[](size_t i) const { return data[i]; }
+};
+
 struct ASTNode {
-    std::string type;
-    std::string value;
-    std::vector<ASTNode*> children;
+    NodeKind kind;
+    uint32_t offset = 0; // source offset of the node's token, for diagnostics
+    std::string_view value; // token text, points into the SourceBuffer
+    NodeList children;
+    int32_t symbol = -1; // symbol table slot a variable declares or refers to, set by semantic analysis
+    int32_t number = 0;  // value of a Literal, length of an array Type
 
-    ASTNode(const std::string& type, const std::string& value)
-        : type(type), value(value), children() {}
+    ASTNode(NodeKind kind, std::string_view value)
+        : kind(kind), value(value), children() {}
+
+    /**
+     * @brief Function to get the source range of the node's token
+     */
+    SourceSpan span() const { return {offset, static_cast<uint32_t>(value.size())}; }
 };
 
 /**
  * @brief Function to handle parsing error
+ * @param message Error message
+ * @param span Source range the error points at
+ * @throws CompileError
  */
-void handleError(const std::string& message);
+void handleError(const std::string& message, SourceSpan span = {});
 /**
  * @brief Function to print AST
  * @param node AST node
  */
 void printAST(const ASTNode* node, int depth = 0);
 
+/**
+ * @brief Function to check whether a node counts towards MAX_NESTING_DEPTH
+ */
+inline bool opensNesting(NodeKind kind) {
+    return kind == NodeKind::Block || kind == NodeKind::If || kind == NodeKind::While || kind == NodeKind::For;
+}
+
+/**
+ * @brief Function to visit every node of a subtree, parents before their children and
+ *        children in order. Uses an explicit stack, so trees of any depth are safe to walk.
+ * @param root Subtree root, ASTNode or const ASTNode
+ * @param visit Called with every node
+ * @param stack Scratch space, kept by callers walking many subtrees so only the first walk allocates
+ */
+template <typename Node, typename Visit>
+void forEachNode(Node* root, Visit visit, std::vector<Node*>& stack) {
+    stack.clear(); // a visit that threw may have left nodes behind
+    stack.push_back(root);
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        visit(node);
+        for (size_t i = node->children.size(); i-- > 0;) {
+            stack.push_back(node->children[i]);
+        }
+    }
+}
+
+template <typename Node, typename Visit>
+void forEachNode(Node* root, Visit visit) {
+    std::vector<Node*> stack;
+    forEachNode(root, visit, stack);
+}
+
+template <typename Node>
+using PostOrderStack = std::vector<std::pair<Node*, size_t>>; // node, next child to visit
+
+/**
+ * @brief Function to visit every node of a subtree, children in order before their parent.
+ *        Uses an explicit stack, so trees of any depth are safe to walk. A node may be
+ *        rewritten when it is visited, its children are done with by then.
+ * @param root Subtree root, ASTNode or const ASTNode
+ * @param visit Called with every node
+ * @param stack Scratch space, kept by callers walking many subtrees so only the first walk allocates
+ */
+template <typename Node, typename Visit>
+void forEachNodePostOrder(Node* root, Visit visit, PostOrderStack<Node>& stack) {
+    if (root->children.empty()) {
+        visit(root); // most expressions are a single variable or literal, they need no stack
+        return;
+    }
+    stack.clear(); // a visit that threw may have left nodes behind
+    stack.emplace_back(root, 0);
+    while (!stack.empty()) {
+        auto& [node, next] = stack.back();
+        if (next < node->children.size()) {
+            Node* child = node->children[next++];
+            if (child->children.empty()) {
+                visit(child); // its turn is now either way, a leaf needs no entry of its own
+            } else {
+                stack.emplace_back(child, 0);
+            }
+            continue;
+        }
+        Node* done = node;
+        stack.pop_back();
+        visit(done);
+    }
+}
+
+template <typename Node, typename Visit>
+void forEachNodePostOrder(Node* root, Visit visit) {
+    PostOrderStack<Node> stack;
+    forEachNodePostOrder(root, visit, stack);
+}
+
 class Parser {
 private:
-    std::vector<Token> tokens;
-    size_t index = 0;
+    Lexer& lexer;
+    DiagnosticEngine& diagnostics;
+    size_t nodes = 0;
+    Arena& arena;
+    // children of nodes under construction, copied into the arena once complete; also the
+    // operand stack of the expression being parsed
+    std::vector<ASTNode*> pending;
+    /**
+     * @brief Binary operator of the expression being parsed, waiting for its right operand
+     */
+    struct PendingOperator {
+        std::string_view op;
+        int precedence;
+    };
+    /**
+     * @brief Parenthesis, call or index opened in the expression being parsed
+     */
+    struct OpenGroup {
+        ASTNode* node;       // Call or Index node, null for a parenthesis
+        size_t operandMark;  // size of the operand stack when the group was opened
+        size_t operatorMark; // size of the operator stack when the group was opened
+    };
+    // stacks of parseExpression, kept between expressions so their storage is reused
+    std::vector<PendingOperator> operators;
+    std::vector<OpenGroup> groups;
+    uint32_t nesting = 0; // blocks and control statements open around the current statement
     /**
      * @brief Function to peek the next token
-     * @return Token
+     * @return Token, valid until the next consume()
      */
-    Token peek();
+    const Token& peek() { return lexer.peek(); }
     /**
      * @brief Function to consume the next token
-     * @return Token
+     * @return Token, copy it if it must outlive further lookahead
+     */
+    const Token& consume() { return lexer.consume(); }
+    /**
+     * @brief Function to get the source range of a token
      */
-    Token consume();
+    SourceSpan spanOf(const Token& token) const;
     /**
-     * @brief Function to expect a token
+     * @brief Function to expect a token, consumed only if it matches
      * @param type Token type
      * @param value Token value
-     * @throws std::exit(1) if token is not as expected
+     * @throws CompileError if token is not as expected
      */
-    void expect(TokenType type, const std::string& value = "");
+    void expect(TokenType type, std::string_view value = {});
+    /**
+     * @brief Function to allocate a node in the arena
+     * @param kind Node kind
+     * @param value Token text of the node
+     * @param children Child nodes, copied into an arena slice
+     * @return ASTNode
+     */
+    ASTNode* makeNode(NodeKind kind, std::string_view value, std::initializer_list<ASTNode*> children = {});
+    /**
+     * @brief Function to allocate a Literal node for a NUMBER token
+     * @param token Number token
+     * @throws CompileError if the number does not fit an int
+     */
+    ASTNode* makeLiteral(const Token& token);
+    /**
+     * @brief Function to move the pending children pushed since mark into an arena slice
+     * @param mark Size of the pending stack before the children were pushed
+     * @return NodeList
+     */
+    NodeList takePending(size_t mark);
+    /**
+     * @brief Function to skip tokens after an error in a statement, past the next ';' or
+     *        the block the statement opened, or up to the next '}', fn or the end of the input
+     */
+    void synchronizeStatement();
+    /**
+     * @brief Function to skip tokens after an error outside of a function body, up to the next fn
+     */
+    void synchronizeFunction();
+    /**
+     * @brief Function to check whether the next token is the given symbol
+     */
+    bool nextIsSymbol(std::string_view symbol) {
+        const Token& token = peek();
+        return token.type == TokenType::SYMBOL && token.value == symbol;
+    }
+    /**
+     * @brief Function to parse statements up to the closing '}' of a block, which is left in place.
+     *        A statement with a syntax error is dropped and parsing resumes after its ';'.
+     * @return Statements
+     */
+    NodeList parseStatements();
 
 public:
-    Parser(const std::vector<Token>& tokens) : tokens(tokens) {}
     /**
-     * @brief Function to parse the tokens
-     * @return ASTNode
+     * @param lexer Token source, tokens are pulled from it while parsing
+     * @param arena Arena owning the nodes
+     * @param diagnostics Collects syntax errors, parsing resumes after each of them
+     */
+    Parser(Lexer& lexer, Arena& arena, DiagnosticEngine& diagnostics)
+        : lexer(lexer), diagnostics(diagnostics), arena(arena) {}
+    /**
+     * @brief Function to parse the tokens. Syntax errors are reported to the DiagnosticEngine and
+     *        the statement or function they occur in is dropped from the tree.
+     * @return Program node holding every function, owned by the arena passed to the constructor
+     * @throws ErrorLimitReached once the diagnostics hold their maximum number of errors
      */
     ASTNode* parse();
+    /**
+     * @brief Function to get the number of nodes created so far
+     */
+    size_t nodeCount() const { return nodes; }
 
 private:
     /**
-     * @brief Function to parse a binary operation
-     * @param exprPrec Precedence of the expression
-     * @param lhs Left hand side of the expression
-     * @return ASTNode
+     * @brief Nesting level opened for the lifetime of the guard, closed on errors as well
      */
-    ASTNode* parseBinaryOpRHS(int exprPrec, ASTNode* lhs);
+    struct NestingGuard {
+        Parser& parser;
+        NestingGuard(Parser& parser, const Token& token);
+        ~NestingGuard() { --parser.nesting; }
+    };
     /**
-     * @brief Function to parse a primary
-     * @return ASTNode
+     * @brief Function to pop the two top operands and push the BinaryOp of the top operator
      */
-    ASTNode* parsePrimary();
+    void reduceOperator();
     /**
      * @brief Function to parse a function
      * @return ASTNode
      */
     ASTNode* parseFunction();
 
+    /**
+     * @brief Function to parse a parameter, name: type
+     * @return ASTNode
+     */
+    ASTNode* parseParameter();
+
+    /**
+     * @brief Function to parse a call statement, the callee name is the next token
+     * @return ASTNode
+     */
+    ASTNode* parseCall();
+
     /**
      * @brief Function to parse a statement
      * @return ASTNode
@@ -81,13 +345,52 @@ private:
     ASTNode* parseStatement();
 
     /**
-     * @brief Function to parse a block
+     * @brief Function to parse a variable declaration
      * @return ASTNode
      */
     ASTNode* parseVariableDeclaration();
 
     /**
-     * @brief Function to parse an expression
+     * @brief Function to parse a type, int or int[N]
+     * @return Type node, number holds N for an array and 0 otherwise
+     */
+    ASTNode* parseType();
+
+    /**
+     * @brief Function to parse an assignment, target = value
+     * @param terminated Whether a ';' follows, not the case for the step of a for loop
+     * @return ASTNode
+     */
+    ASTNode* parseAssignment(bool terminated);
+
+    /**
+     * @brief Function to parse a block, { statements }
+     * @return ASTNode
+     */
+    ASTNode* parseBlock();
+
+    /**
+     * @brief Function to parse an if statement, else if chains nest as If nodes
+     * @return ASTNode
+     */
+    ASTNode* parseIf();
+
+    /**
+     * @brief Function to parse a while loop
+     * @return ASTNode
+     */
+    ASTNode* parseWhile();
+
+    /**
+     * @brief Function to parse a for loop, for (init; condition; step) body
+     * @return ASTNode
+     */
+    ASTNode* parseFor();
+
+    /**
+     * @brief Function to parse an expression. Operator precedence parsing over explicit
+     *        operand, operator and group stacks, so the native stack stays bounded and the
+     *        time linear however long or deeply parenthesized the expression is.
      * @return ASTNode
      */
     ASTNode* parseExpression();
@@ -0,0 +1,462 @@
+#include "ast_file.h"
+#include "../logger/logger.h"
+#include "../jit/runtime.h"
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Strings of the file, each distinct text stored once
+ */
+class StringTable {
+public:
+    uint32_t add(std::string_view text) {
+        auto [entry, inserted] = offsets.try_emplace(text, static_cast<uint32_t>(bytes.size()));
+        if (inserted) {
+            bytes.append(text);
+        }
+        return entry->second;
+    }
+
+    const std::string& data() const { return bytes; }
+
+private:
+    std::unordered_map<std::string_view, uint32_t> offsets;
+    std::string bytes;
+};
+
+/**
+ * @brief Function to read a fixed-layout record, the file need not be aligned for it
+ */
+template <typename T>
+T readRecord(const char* data, size_t index) {
+    T record;
+    std::memcpy(&record, data + index * sizeof(T), sizeof(T));
+    return record;
+}
+
+[[noreturn]] void malformed(const std::string& reason) {
+    throw CompileError("Malformed AST file: " + reason);
+}
+
+bool isExpression(const ASTNode* node) {
+    switch (node->kind) {
+        case NodeKind::BinaryOp: case NodeKind::Literal: case NodeKind::Variable: case NodeKind::Call: case NodeKind::Index:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isStatement(const ASTNode* node) {
+    switch (node->kind) {
+        case NodeKind::VariableDeclaration: case NodeKind::Assignment: case NodeKind::ReturnStatement: case NodeKind::Call:
+        case NodeKind::Block: case NodeKind::If: case NodeKind::While: case NodeKind::For:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isOperator(std::string_view op) {
+    for (std::string_view known : {"+", "-", "*", "/", "<", "<=", ">", ">=", "==", "!="}) {
+        if (op == known) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Function to check the symbols every function owns: parameters first, matching the
+ *        recorded signature, then variables; arrays have a length the parser would accept
+ */
+void validateSymbols(const SymbolTable& symbolTable) {
+    for (int32_t slot = 0; slot < static_cast<int32_t>(symbolTable.size()); ++slot) {
+        const Symbol& symbol = symbolTable.getSymbol(slot);
+        if (symbol.type == ValueType::IntArray && (symbol.length == 0 || symbol.length > MAX_ARRAY_LENGTH)) {
+            malformed("invalid array length of symbol " + std::to_string(slot));
+        }
+        if (symbol.kind != SymbolKind::Function) continue;
+        if (symbol.arity > symbol.localCount) {
+            malformed("parameters of function symbol " + std::to_string(slot) + " out of range");
+        }
+        for (uint32_t i = 0; i < symbol.localCount; ++i) {
+            int32_t localSlot = symbol.firstLocal + static_cast<int32_t>(i);
+            const Symbol& local = symbolTable.getSymbol(localSlot);
+            bool parameter = i < symbol.arity;
+            uint32_t length = parameter ? symbolTable.parameterLength(slot, i) : 0;
+            if (local.kind != (parameter ? SymbolKind::Parameter : SymbolKind::Variable) ||
+                (parameter && (local.type == ValueType::IntArray ? local.length : 0) != length)) {
+                malformed("invalid local symbol " + std::to_string(localSlot) + " of function symbol " + std::to_string(slot));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Function to check what code generation and the bytecode compiler rely on beyond the
+ *        file's layout: the children of every kind of node, the kind of symbol it refers to
+ *        and the types of its operands. Parents come before their children in the node array.
+ */
+void validateNodes(const ASTNode* nodes, uint32_t count, const SymbolTable& symbolTable) {
+    // function symbol whose locals a node may refer to, -1 outside functions
+    std::vector<int32_t> owner(count, -1);
+    std::vector<bool> defined(symbolTable.size(), false);
+    std::vector<int32_t> called;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const ASTNode* node = nodes + i;
+        auto fail = [&](const char* reason) {
+            malformed(std::string(nodeKindName(node->kind)) + " node " + std::to_string(i) + " " + reason);
+        };
+        auto children = [&](size_t least, size_t most) {
+            if (node->children.size() < least || node->children.size() > most) fail("has the wrong number of children");
+        };
+        auto function = [&]() -> const Symbol& {
+            if (node->symbol < 0 || symbolTable.getSymbol(node->symbol).kind != SymbolKind::Function) {
+                fail("does not refer to a function");
+            }
+            return symbolTable.getSymbol(node->symbol);
+        };
+        auto local = [&]() -> const Symbol& {
+            const Symbol* function = owner[i] >= 0 ? &symbolTable.getSymbol(owner[i]) : nullptr;
+            if (!function || node->symbol < function->firstLocal ||
+                node->symbol >= function->firstLocal + static_cast<int32_t>(function->localCount)) {
+                fail("does not refer to a variable of its function");
+            }
+            return symbolTable.getSymbol(node->symbol);
+        };
+        // operands are checked as nodes of their own later, a symbol out of place is caught there
+        auto type = [&](const ASTNode* operand) {
+            bool variable = operand->kind == NodeKind::Variable && operand->symbol >= 0;
+            return variable ? symbolTable.getSymbol(operand->symbol).type : ValueType::Int;
+        };
+        auto operand = [&](size_t child) {
+            if (!isExpression(node->children[child]) || type(node->children[child]) != ValueType::Int) {
+                fail("has an operand that is not an int expression");
+            }
+        };
+        auto statements = [&](size_t first) {
+            for (size_t child = first; child < node->children.size(); ++child) {
+                if (!isStatement(node->children[child])) fail("has a child that is not a statement");
+            }
+        };
+        auto kindOf = [&](size_t child, NodeKind kind) {
+            if (node->children[child]->kind != kind) fail("has a child of the wrong kind");
+        };
+
+        switch (node->kind) {
+        case NodeKind::Program:
+            for (size_t child = 0; child < node->children.size(); ++child) kindOf(child, NodeKind::Function);
+            break;
+        case NodeKind::Function: {
+            const Symbol& symbol = function();
+            if (defined[node->symbol]) fail("defines its function a second time");
+            if (isRuntimeName(symbolTable.nameOf(node->symbol))) fail("defines a function reserved by the runtime");
+            if (symbolTable.nameOf(node->symbol) == "main" && symbol.arity != 0) fail("main must not take parameters");
+            defined[node->symbol] = true;
+            children(symbol.arity, SIZE_MAX);
+            for (uint32_t parameter = 0; parameter < symbol.arity; ++parameter) {
+                kindOf(parameter, NodeKind::Parameter);
+                if (node->children[parameter]->symbol != symbol.firstLocal + static_cast<int32_t>(parameter)) {
+                    fail("has a parameter out of order");
+                }
+            }
+            statements(symbol.arity);
+            break;
+        }
+        case NodeKind::Parameter:
+            children(1, 1);
+            kindOf(0, NodeKind::Type);
+            local();
+            break;
+        case NodeKind::Type:
+        case NodeKind::Literal:
+            children(0, 0);
+            break;
+        case NodeKind::VariableDeclaration: {
+            children(1, 2);
+            const Symbol& symbol = local();
+            if (symbol.kind != SymbolKind::Variable) fail("declares a parameter");
+            const ASTNode* initializer = node->children[node->children.size() - 1];
+            if (node->children.size() == 2) kindOf(0, NodeKind::Type);
+            if (initializer->kind == NodeKind::Type) {
+                // an array has no initializer, its length is taken from the Type node
+                if (node->children.size() != 1 || symbol.type != ValueType::IntArray ||
+                    initializer->number != static_cast<int32_t>(symbol.length)) {
+                    fail("declares an array that does not match its symbol");
+                }
+            } else {
+                operand(node->children.size() - 1);
+                if (symbol.type != ValueType::Int) fail("initializes an array");
+            }
+            break;
+        }
+        case NodeKind::ReturnStatement:
+            children(1, 1);
+            operand(0);
+            break;
+        case NodeKind::BinaryOp:
+            children(2, 2);
+            operand(0);
+            operand(1);
+            if (!isOperator(node->value)) fail("has no valid operator");
+            break;
+        case NodeKind::Variable:
+            children(0, 0);
+            local();
+            break;
+        case NodeKind::Call: {
+            const Symbol& symbol = function();
+            children(symbol.arity, symbol.arity);
+            for (uint32_t argument = 0; argument < symbol.arity; ++argument) {
+                uint32_t length = symbolTable.parameterLength(node->symbol, argument);
+                const ASTNode* passed = node->children[argument];
+                if (length == 0) {
+                    operand(argument);
+                } else if (passed->kind != NodeKind::Variable || type(passed) != ValueType::IntArray ||
+                           symbolTable.getSymbol(passed->symbol).length != length) {
+                    fail("passes an argument that does not match the parameter");
+                }
+            }
+            called.push_back(node->symbol);
+            break;
+        }
+        case NodeKind::Index: {
+            children(1, 1);
+            operand(0);
+            const Symbol& array = local();
+            if (array.type != ValueType::IntArray) fail("indexes a variable that is not an array");
+            // code generation only checks indexes that are not constants
+            const ASTNode* index = node->children[0];
+            if (index->kind == NodeKind::Literal && (index->number < 0 || static_cast<uint32_t>(index->number) >= array.length)) {
+                malformed("Index " + std::to_string(index->number) + " is out of bounds for int[" +
+                          std::to_string(array.length) + "]");
+            }
+            break;
+        }
+        case NodeKind::Assignment: {
+            children(2, 2);
+            const ASTNode* target = node->children[0];
+            if (target->kind != NodeKind::Index && (target->kind != NodeKind::Variable || type(target) != ValueType::Int)) {
+                fail("assigns to something that is not an int variable or array element");
+            }
+            operand(1);
+            break;
+        }
+        case NodeKind::Block:
+            statements(0);
+            break;
+        case NodeKind::If:
+            children(2, 3);
+            operand(0);
+            kindOf(1, NodeKind::Block);
+            if (node->children.size() == 3 && node->children[2]->kind != NodeKind::If) kindOf(2, NodeKind::Block);
+            break;
+        case NodeKind::While:
+            children(2, 2);
+            operand(0);
+            kindOf(1, NodeKind::Block);
+            break;
+        case NodeKind::For:
+            children(4, 4);
+            if (node->children[0]->kind != NodeKind::Assignment) kindOf(0, NodeKind::VariableDeclaration);
+            operand(1);
+            kindOf(2, NodeKind::Assignment);
+            kindOf(3, NodeKind::Block);
+            break;
+        }
+
+        for (const ASTNode* child : node->children) {
+            owner[child - nodes] = node->kind == NodeKind::Function ? node->symbol : owner[i];
+        }
+    }
+
+    for (int32_t callee : called) {
+        if (!defined[callee]) {
+            malformed("call of function " + std::string(symbolTable.nameOf(callee)) + ", which is not defined");
+        }
+    }
+}
+
+} // namespace
+
+bool isASTFile(std::string_view data) {
+    return data.size() >= sizeof(AST_FILE_MAGIC) && std::memcmp(data.data(), AST_FILE_MAGIC, sizeof(AST_FILE_MAGIC)) == 0;
+}
+
+void serializeAST(const ASTNode* program, const SymbolTable& symbolTable, llvm::raw_ostream& out) {
+    StringTable strings;
+
+    // breadth-first, so the children of every node are contiguous and follow those of the previous node
+    std::vector<const ASTNode*> order{program};
+    std::vector<SerializedNode> nodes;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const ASTNode* node = order[i];
+        SerializedNode& serialized = nodes.emplace_back();
+        serialized.kind = static_cast<uint8_t>(node->kind);
+        serialized.offset = node->offset;
+        serialized.value = strings.add(node->value);
+        serialized.valueLength = static_cast<uint32_t>(node->value.size());
+        serialized.symbol = node->symbol;
+        serialized.number = node->number;
+        serialized.firstChild = node->children.empty() ? 0 : static_cast<uint32_t>(order.size() - i);
+        serialized.childCount = static_cast<uint32_t>(node->children.size());
+        order.insert(order.end(), node->children.begin(), node->children.end());
+    }
+
+    std::vector<SerializedSymbol> symbols;
+    std::vector<uint32_t> parameterLengths;
+    for (size_t slot = 0; slot < symbolTable.size(); ++slot) {
+        const Symbol& symbol = symbolTable.getSymbol(static_cast<int32_t>(slot));
+        std::string_view name = symbolTable.nameOf(static_cast<int32_t>(slot));
+        SerializedSymbol& serialized = symbols.emplace_back();
+        serialized.name = strings.add(name);
+        serialized.nameLength = static_cast<uint32_t>(name.size());
+        serialized.type = static_cast<uint8_t>(symbol.type);
+        serialized.kind = static_cast<uint8_t>(symbol.kind);
+        serialized.depth = symbol.depth;
+        serialized.shadowed = symbol.shadowed;
+        serialized.length = symbol.length;
+        serialized.arity = symbol.arity;
+        serialized.firstLocal = symbol.firstLocal;
+        serialized.localCount = symbol.localCount;
+        serialized.parameters = static_cast<uint32_t>(parameterLengths.size());
+        if (symbol.kind == SymbolKind::Function) {
+            for (uint32_t i = 0; i < symbol.arity; ++i) {
+                parameterLengths.push_back(symbolTable.parameterLength(static_cast<int32_t>(slot), i));
+            }
+        }
+    }
+
+    AstFileHeader header;
+    std::memcpy(header.magic, AST_FILE_MAGIC, sizeof(header.magic));
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.symbolCount = static_cast<uint32_t>(symbols.size());
+    header.parameterLengthCount = static_cast<uint32_t>(parameterLengths.size());
+    header.stringBytes = static_cast<uint32_t>(strings.data().size());
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(SerializedNode));
+    out.write(reinterpret_cast<const char*>(symbols.data()), symbols.size() * sizeof(SerializedSymbol));
+    out.write(reinterpret_cast<const char*>(parameterLengths.data()), parameterLengths.size() * sizeof(uint32_t));
+    out << strings.data();
+}
+
+bool writeASTFile(const ASTNode* program, const SymbolTable& symbolTable, const std::string& filename) {
+    log::debug("Writing AST to file: {}", filename);
+    std::error_code EC;
+    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+        log::error("Could not open file {}: {}", filename, EC.message());
+        return false;
+    }
+    serializeAST(program, symbolTable, dest);
+    dest.close();
+    if (dest.has_error()) {
+        log::error("Could not write file {}: {}", filename, dest.error().message());
+        dest.clear_error();
+        return false;
+    }
+    return true;
+}
+
+ASTNode* loadASTFile(std::string_view data, Arena& arena, SymbolTable& symbolTable) {
+    if (data.size() < sizeof(AstFileHeader) || !isASTFile(data)) {
+        malformed("missing header");
+    }
+    AstFileHeader header = readRecord<AstFileHeader>(data.data(), 0);
+    uint64_t expected = sizeof(AstFileHeader) + uint64_t(header.nodeCount) * sizeof(SerializedNode) +
+                        uint64_t(header.symbolCount) * sizeof(SerializedSymbol) +
+                        uint64_t(header.parameterLengthCount) * sizeof(uint32_t) + header.stringBytes;
+    if (expected != data.size()) {
+        malformed("expected " + std::to_string(expected) + " bytes, found " + std::to_string(data.size()));
+    }
+    if (header.nodeCount == 0) {
+        malformed("no program node");
+    }
+
+    const char* nodeData = data.data() + sizeof(AstFileHeader);
+    const char* symbolData = nodeData + size_t(header.nodeCount) * sizeof(SerializedNode);
+    const char* lengthData = symbolData + size_t(header.symbolCount) * sizeof(SerializedSymbol);
+    const char* stringData = lengthData + size_t(header.parameterLengthCount) * sizeof(uint32_t);
+    auto text = [&](uint32_t offset, uint32_t length) {
+        if (uint64_t(offset) + length > header.stringBytes) {
+            malformed("string out of range");
+        }
+        return std::string_view(stringData + offset, length);
+    };
+
+    for (uint32_t slot = 0; slot < header.symbolCount; ++slot) {
+        SerializedSymbol in = readRecord<SerializedSymbol>(symbolData, slot);
+        if (in.type > static_cast<uint8_t>(ValueType::IntArray) || in.kind > static_cast<uint8_t>(SymbolKind::Function) ||
+            in.shadowed >= static_cast<int32_t>(header.symbolCount) ||
+            uint64_t(uint32_t(in.firstLocal)) + in.localCount > header.symbolCount ||
+            uint64_t(in.parameters) + in.arity > header.parameterLengthCount) {
+            malformed("invalid symbol " + std::to_string(slot));
+        }
+        Symbol symbol{0, static_cast<ValueType>(in.type), static_cast<SymbolKind>(in.kind), in.depth, in.shadowed};
+        symbol.length = in.length;
+        symbol.arity = in.arity;
+        symbol.firstLocal = in.firstLocal;
+        symbol.localCount = in.localCount;
+        int32_t restored = symbolTable.restoreSymbol(text(in.name, in.nameLength), symbol);
+        if (symbol.kind == SymbolKind::Function) {
+            std::vector<uint32_t> lengths(in.arity);
+            for (uint32_t i = 0; i < in.arity; ++i) {
+                lengths[i] = readRecord<uint32_t>(lengthData, in.parameters + i);
+            }
+            symbolTable.setParameterLengths(restored, lengths);
+        }
+    }
+
+    // every node but the root is some node's child, in node order, so one pointer array covers all child lists
+    ASTNode* nodes = arena.allocateArray<ASTNode>(header.nodeCount);
+    ASTNode** children = arena.allocateArray<ASTNode*>(header.nodeCount - 1);
+    // statements nest no deeper than the parser allows, code generation walks them recursively
+    std::vector<uint32_t> nesting(header.nodeCount);
+    uint64_t nextChild = 1;
+    for (uint32_t i = 0; i < header.nodeCount; ++i) {
+        SerializedNode in = readRecord<SerializedNode>(nodeData, i);
+        if (in.kind > static_cast<uint8_t>(NodeKind::For) || (i == 0) != (in.kind == static_cast<uint8_t>(NodeKind::Program))) {
+            malformed("invalid kind of node " + std::to_string(i));
+        }
+        if (in.childCount && uint64_t(i) + in.firstChild != nextChild) {
+            malformed("children of node " + std::to_string(i) + " out of order");
+        }
+        if (nextChild + in.childCount > header.nodeCount) {
+            malformed("children of node " + std::to_string(i) + " out of range");
+        }
+        if (in.symbol < -1 || in.symbol >= static_cast<int32_t>(header.symbolCount)) {
+            malformed("invalid symbol of node " + std::to_string(i));
+        }
+
+        nesting[i] += opensNesting(static_cast<NodeKind>(in.kind));
+        if (nesting[i] > MAX_NESTING_DEPTH) {
+            malformed("statements of node " + std::to_string(i) + " nested too deeply");
+        }
+
+        ASTNode* node = new (nodes + i) ASTNode(static_cast<NodeKind>(in.kind), text(in.value, in.valueLength));
+        node->offset = in.offset;
+        node->symbol = in.symbol;
+        node->number = in.number;
+        if (in.childCount) {
+            node->children = {children + (nextChild - 1), in.childCount};
+            for (uint32_t child = 0; child < in.childCount; ++child) {
+                children[nextChild - 1 + child] = nodes + nextChild + child;
+                nesting[nextChild + child] = nesting[i];
+            }
+            nextChild += in.childCount;
+        }
+    }
+    if (nextChild != header.nodeCount) {
+        malformed("unreachable nodes");
+    }
+    validateSymbols(symbolTable);
+    validateNodes(nodes, header.nodeCount, symbolTable);
+    return nodes;
+}
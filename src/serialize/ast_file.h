@@ -0,0 +1,102 @@
+#ifndef AST_FILE_H
+#define AST_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <llvm/Support/raw_ostream.h>
+#include "../parser/parser.h"
+#include "../parser/arena.h"
+#include "../analysis/analysis.h"
+
+/**
+ * Binary form of a resolved and folded program, written by --emit=ast so code generation can
+ * run on another machine or later without the front end. All sections are fixed-layout and
+ * 4-byte aligned, in host byte order:
+ *
+ *   AstFileHeader
+ *   SerializedNode[nodeCount]      breadth-first, the root first; every node's children are
+ *                                  contiguous and stored as an index relative to the node
+ *   SerializedSymbol[symbolCount]  symbol table in slot order
+ *   uint32_t[parameterLengthCount] array length of every function parameter, 0 for an int
+ *   char[stringBytes]              interned node values and symbol names
+ */
+
+constexpr char AST_FILE_MAGIC[8] = {'N', 'V', 'A', 'S', 'T', '0', '0', '1'};
+
+struct AstFileHeader {
+    char magic[8];
+    uint32_t nodeCount;
+    uint32_t symbolCount;
+    uint32_t parameterLengthCount;
+    uint32_t stringBytes;
+};
+
+struct SerializedNode {
+    uint8_t kind;         // NodeKind
+    uint8_t reserved[3];
+    uint32_t offset;      // source offset, for diagnostics
+    uint32_t value;       // offset of the value in the string table
+    uint32_t valueLength;
+    int32_t symbol;
+    int32_t number;
+    uint32_t firstChild;  // index of the first child minus the node's own index, 0 without children
+    uint32_t childCount;
+};
+
+struct SerializedSymbol {
+    uint32_t name;        // offset of the name in the string table
+    uint32_t nameLength;
+    uint8_t type;         // ValueType
+    uint8_t kind;         // SymbolKind
+    uint8_t reserved[2];
+    uint32_t depth;
+    int32_t shadowed;
+    uint32_t length;
+    uint32_t arity;
+    int32_t firstLocal;
+    uint32_t localCount;
+    uint32_t parameters;  // index of the first parameter length, functions only
+};
+
+static_assert(sizeof(AstFileHeader) == 24, "AstFileHeader layout is part of the file format");
+static_assert(sizeof(SerializedNode) == 32, "SerializedNode layout is part of the file format");
+static_assert(sizeof(SerializedSymbol) == 40, "SerializedSymbol layout is part of the file format");
+
+/**
+ * @brief Function to check whether a file holds a serialized AST rather than source
+ * @param data Contents of the file
+ */
+bool isASTFile(std::string_view data);
+
+/**
+ * @brief Function to serialize a program and the symbol table it was resolved against
+ * @param program Program node, analyzed and folded
+ * @param symbolTable Table the program was resolved against
+ * @param out Stream the file contents are written to
+ */
+void serializeAST(const ASTNode* program, const SymbolTable& symbolTable, llvm::raw_ostream& out);
+
+/**
+ * @brief Function to write a program and the symbol table it was resolved against to a file
+ * @param program Program node, analyzed and folded
+ * @param symbolTable Table the program was resolved against
+ * @param filename Output path
+ * @return false if the file could not be written
+ */
+bool writeASTFile(const ASTNode* program, const SymbolTable& symbolTable, const std::string& filename);
+
+/**
+ * @brief Function to load a program written by writeASTFile. Node values and symbol names
+ *        view into data instead of being copied, and the nodes are rebuilt in one pass over
+ *        the node array without tokenizing or parsing.
+ * @param data Contents of the file, e.g. a SourceBuffer, must outlive the program and table
+ * @param arena Arena owning the nodes
+ * @param symbolTable Empty table, filled with the saved symbols
+ * @return Program node
+ * @throws CompileError if the file is truncated, its structure is inconsistent or a node
+ *         does not fit its kind: children, symbol or operand types other than the front end produces
+ */
+ASTNode* loadASTFile(std::string_view data, Arena& arena, SymbolTable& symbolTable);
+
+#endif // AST_FILE_H
@@ -0,0 +1,53 @@
+#include "client.h"
+#include "protocol.h"
+#include "../logger/logger.h"
+#include <unistd.h>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+bool runClient(const std::string& socketPath, int argc, char** argv, int& status) {
+    // a program that traps or writes out of bounds must not take the long-lived server with it
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument == "--run" || argument == "--interp") {
+            log::debug("{} runs in-process, not on the compile server", argument);
+            return false;
+        }
+    }
+
+    int fd = connectToServer(socketPath);
+    if (fd < 0) {
+        log::debug("No compile server on {}", socketPath);
+        return false;
+    }
+
+    std::vector<char> workingDirectory(4096);
+    while (!::getcwd(workingDirectory.data(), workingDirectory.size())) {
+        workingDirectory.resize(workingDirectory.size() * 2);
+    }
+    std::string payload(workingDirectory.data());
+    payload += '\0';
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument == "--client" || argument.rfind("--socket=", 0) == 0) continue;
+        payload += argument;
+        payload += '\0';
+    }
+
+    // anything already written must come out before the server's output on the same streams
+    log::flush();
+    std::cout.flush();
+
+    int32_t result = 1;
+    if (!sendRequest(fd, payload)) {
+        log::error("Failed to send the compile request to {}", socketPath);
+    } else if (!receiveAll(fd, &result, sizeof(result))) {
+        log::error("Compile server on {} closed the connection", socketPath);
+        result = 1;
+    }
+    ::close(fd);
+    status = result;
+    return true;
+}
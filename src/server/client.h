@@ -0,0 +1,19 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <string>
+
+/**
+ * @brief Function to forward a command line to a running server and wait for its result.
+ *        The server writes to this process's stdout and stderr directly. Command lines that
+ *        run the program (--run, --interp) are never forwarded, the caller compiles them itself.
+ * @param socketPath Socket the server listens on
+ * @param argc Argument count of the client's command line
+ * @param argv Argument vector, --client and --socket are not forwarded
+ * @param status Exit status of the compile on the server
+ * @return false if the command line runs the program or no server accepted the connection,
+ *         nothing was compiled then
+ */
+bool runClient(const std::string& socketPath, int argc, char** argv, int& status);
+
+#endif // CLIENT_H
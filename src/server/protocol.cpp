@@ -0,0 +1,119 @@
+#include "protocol.h"
+#include "../logger/logger.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+std::string defaultSocketPath() {
+    const char* runtimeDirectory = std::getenv("XDG_RUNTIME_DIR");
+    if (runtimeDirectory && *runtimeDirectory) {
+        return std::string(runtimeDirectory) + "/cts.sock";
+    }
+    return "/tmp/cts-" + std::to_string(::getuid()) + ".sock";
+}
+
+bool makeSocketAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    if (path.size() >= sizeof(address.sun_path)) {
+        log::error("Socket path too long: {}", path);
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int connectToServer(const std::string& path) {
+    sockaddr_un address;
+    if (!makeSocketAddress(path, address)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size) {
+        // MSG_NOSIGNAL, a peer that went away must not take the process down with SIGPIPE
+        ssize_t written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool receiveAll(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size) {
+        ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        bytes += received;
+        size -= received;
+    }
+    return true;
+}
+
+bool sendRequest(int fd, const std::string& payload) {
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    int streams[2] = {STDOUT_FILENO, STDERR_FILENO};
+
+    iovec vector{&size, sizeof(size)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(streams))] = {};
+    msghdr message{};
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(streams));
+    std::memcpy(CMSG_DATA(header), streams, sizeof(streams));
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != static_cast<ssize_t>(sizeof(size))) return false;
+    return sendAll(fd, payload.data(), payload.size());
+}
+
+bool receiveRequest(int fd, int (&streams)[2], std::string& payload) {
+    uint32_t size = 0;
+    iovec vector{&size, sizeof(size)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(streams))] = {};
+    msghdr message{};
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return false;
+
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS &&
+            header->cmsg_len == CMSG_LEN(sizeof(streams))) {
+            std::memcpy(streams, CMSG_DATA(header), sizeof(streams));
+        }
+    }
+    if (static_cast<size_t>(received) < sizeof(size) &&
+        !receiveAll(fd, reinterpret_cast<char*>(&size) + received, sizeof(size) - received)) {
+        return false;
+    }
+    if (streams[0] < 0 || streams[1] < 0 || size > MAX_REQUEST_BYTES) return false;
+    payload.resize(size);
+    return receiveAll(fd, payload.data(), size);
+}
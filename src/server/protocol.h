@@ -0,0 +1,63 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <sys/un.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Wire format between --server and its clients, both ends run on the same machine so integers are native-endian:
+//   request  uint32 payload size, sent together with the client's stdout and stderr as SCM_RIGHTS,
+//            then the payload: working directory and arguments, each NUL-terminated
+//   response int32 exit status once the compile is done
+// Nothing here depends on LLVM, the thin client links it without the compiler.
+
+constexpr uint32_t MAX_REQUEST_BYTES = 1 << 20;
+
+/**
+ * @brief Function to get the socket used when --socket is not given
+ * @return $XDG_RUNTIME_DIR/cts.sock, or /tmp/cts-<uid>.sock without a runtime directory
+ */
+std::string defaultSocketPath();
+
+/**
+ * @brief Function to fill a Unix socket address
+ * @return false if the path does not fit
+ */
+bool makeSocketAddress(const std::string& path, sockaddr_un& address);
+
+/**
+ * @brief Function to connect to a server socket
+ * @return Connected descriptor, -1 if nothing listens on path
+ */
+int connectToServer(const std::string& path);
+
+/**
+ * @brief Function to write a whole buffer to a socket
+ * @return false if the peer went away
+ */
+bool sendAll(int fd, const void* data, size_t size);
+
+/**
+ * @brief Function to read a whole buffer from a socket
+ * @return false if the peer went away first
+ */
+bool receiveAll(int fd, void* data, size_t size);
+
+/**
+ * @brief Function to send a request, passing this process's stdout and stderr along
+ * @param fd Connected socket
+ * @param payload Working directory and arguments, each NUL-terminated
+ */
+bool sendRequest(int fd, const std::string& payload);
+
+/**
+ * @brief Function to receive a request
+ * @param fd Accepted connection
+ * @param streams Client's stdout and stderr, -1 where none arrived; owned by the caller either way
+ * @param payload Working directory and arguments, each NUL-terminated
+ * @return false on a malformed or incomplete request
+ */
+bool receiveRequest(int fd, int (&streams)[2], std::string& payload);
+
+#endif // PROTOCOL_H
@@ -0,0 +1,217 @@
+#include "server.h"
+#include "protocol.h"
+#include "../driver/driver.h"
+#include "../cache/cache.h"
+#include "../logger/logger.h"
+#include "../target/target.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+class CompileServer {
+public:
+    explicit CompileServer(int home) : home(home) {}
+
+    /**
+     * @brief Function to serve one connection, from reading the request to sending the status
+     */
+    void handle(int connection) {
+        int streams[2] = {-1, -1};
+        std::string payload;
+        if (!receiveRequest(connection, streams, payload)) {
+            // a connection that sent nothing is a starting server probing the socket
+            if (streams[0] >= 0 || streams[1] >= 0) log::warn("Dropped a malformed compile request");
+            for (int stream : streams) {
+                if (stream >= 0) ::close(stream);
+            }
+            return;
+        }
+
+        std::vector<std::string> fields;
+        for (size_t start = 0; start < payload.size();) {
+            size_t end = payload.find('\0', start);
+            if (end == std::string::npos) end = payload.size();
+            fields.emplace_back(payload, start, end - start);
+            start = end + 1;
+        }
+
+        // the client's streams stand in for ours, so logs and diagnostics reach its terminal
+        log::flush();
+        std::cout.flush();
+        std::cerr.flush();
+        int savedOut = ::dup(STDOUT_FILENO);
+        int savedErr = ::dup(STDERR_FILENO);
+        ::dup2(streams[0], STDOUT_FILENO);
+        ::dup2(streams[1], STDERR_FILENO);
+        ::close(streams[0]);
+        ::close(streams[1]);
+
+        int32_t status = compile(fields);
+
+        std::cout.flush();
+        std::cerr.flush();
+        log::flush();
+        ::dup2(savedOut, STDOUT_FILENO);
+        ::dup2(savedErr, STDERR_FILENO);
+        ::close(savedOut);
+        ::close(savedErr);
+        if (::fchdir(home) != 0) {
+            log::error("Failed to return to the server's working directory: {}", std::strerror(errno));
+        }
+
+        if (!sendAll(connection, &status, sizeof(status))) {
+            log::warn("Client disconnected before its compile finished");
+        }
+    }
+
+private:
+    /**
+     * @brief Function to compile a request's command line in its working directory
+     * @param fields Working directory followed by the arguments
+     * @return Exit status for the client
+     */
+    int32_t compile(const std::vector<std::string>& fields) {
+        auto startTime = std::chrono::steady_clock::now();
+        if (fields.empty() || ::chdir(fields[0].c_str()) != 0) {
+            log::error("Cannot enter the client's working directory: {}", std::strerror(errno));
+            return 1;
+        }
+
+        std::vector<std::string> arguments(fields.begin(), fields.end());
+        arguments[0] = "cts";
+        std::vector<char*> argv;
+        for (std::string& argument : arguments) argv.push_back(argument.data());
+        argv.push_back(nullptr);
+
+        // --log-level applies to this request only
+        LogLevel level = log::level();
+        Options options;
+        int32_t status = 1;
+        if (!parseOptions(static_cast<int>(arguments.size()), argv.data(), options)) {
+            printUsage();
+        } else if (options.version) {
+            printVersion();
+            status = 0;
+        } else if (options.server || options.client) {
+            log::error("--server and --client cannot be forwarded to a server");
+        } else if (options.run || options.interp) {
+            // the program would run inside the server, a trap or a stray write would take it down
+            log::error("{} is not run on the compile server, run cts directly", options.run ? "--run" : "--interp");
+        } else {
+            status = compileAll(options, startTime, cacheFor(options, fields[0]));
+            if (status == 0) {
+                log::info("Compilation successful");
+            }
+        }
+        log::setLevel(level);
+        return status;
+    }
+
+    /**
+     * @brief Function to get the cache of a request, opened once per directory and kept warm
+     * @return Cache, null if the request does not use one
+     */
+    CompilationCache* cacheFor(const Options& options, const std::string& workingDirectory) {
+        if (options.cacheDir.empty()) return nullptr;
+        // made absolute, the server changes directory between requests
+        llvm::SmallString<256> directory(options.cacheDir);
+        llvm::sys::fs::make_absolute(workingDirectory, directory);
+        std::unique_ptr<CompilationCache>& cache = caches[std::string(directory.str())];
+        if (!cache) {
+            cache = std::make_unique<CompilationCache>(std::string(directory.str()), options.cacheMaxBytes);
+        }
+        return cache.get();
+    }
+
+    int home;
+    std::map<std::string, std::unique_ptr<CompilationCache>> caches;
+};
+
+} // namespace
+
+int runServer(const Options& options) {
+    std::string path = options.socketPath.empty() ? defaultSocketPath() : options.socketPath;
+    sockaddr_un address;
+    if (!makeSocketAddress(path, address)) {
+        return 1;
+    }
+    int existing = connectToServer(path);
+    if (existing >= 0) {
+        ::close(existing);
+        log::error("A compile server is already listening on {}", path);
+        return 1;
+    }
+    ::unlink(path.c_str()); // left behind by a server that did not shut down cleanly
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        log::error("Failed to create socket: {}", std::strerror(errno));
+        return 1;
+    }
+    // requests run with the server's rights, only its owner may connect
+    mode_t previousMask = ::umask(0077);
+    int bound = ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::umask(previousMask);
+    if (bound != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        log::error("Failed to listen on {}: {}", path, std::strerror(errno));
+        ::close(listener);
+        return 1;
+    }
+
+    // no SA_RESTART, so a signal interrupts accept and the loop sees the stop request
+    struct sigaction stop {};
+    stop.sa_handler = requestStop;
+    ::sigaction(SIGINT, &stop, nullptr);
+    ::sigaction(SIGTERM, &stop, nullptr);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    // paid once here instead of in every compile
+    initializeNativeTarget();
+    createHostTargetMachine(OptLevel::O0);
+
+    int home = ::open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    CompileServer server(home);
+    log::info("Serving compile requests on {}", path);
+
+    int status = 0;
+    while (!stopRequested) {
+        int connection = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            log::error("Failed to accept a connection: {}", std::strerror(errno));
+            status = 1;
+            break;
+        }
+        server.handle(connection);
+        ::close(connection);
+    }
+
+    ::close(listener);
+    ::close(home);
+    ::unlink(path.c_str());
+    log::info("Compile server stopped");
+    return status;
+}
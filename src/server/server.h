@@ -0,0 +1,19 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include "../driver/options.h"
+
+/**
+ * @brief Function to serve compile requests on a Unix socket until SIGINT or SIGTERM.
+ *        LLVM's target registry, the host target and opened compilation caches stay warm
+ *        between requests. Requests are handled one at a time: the client's stdout and
+ *        stderr are passed with the request and stand in for the server's own while its
+ *        command line is compiled in the client's working directory. --run and --interp
+ *        are rejected, client code never executes inside the server.
+ * @param options Parsed options, socketPath selects the socket
+ * @return 0 after a clean shutdown, 1 if the socket could not be set up
+ */
+int runServer(const Options& options);
+
+#endif // SERVER_H
@@ -0,0 +1,74 @@
+#include "source_buffer.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+SourceBuffer::~SourceBuffer() {
+    release();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : filename(std::move(other.filename)), data(other.data), size(other.size), mapped(other.mapped) {
+    other.data = nullptr;
+    other.size = 0;
+    other.mapped = false;
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        filename = std::move(other.filename);
+        data = other.data;
+        size = other.size;
+        mapped = other.mapped;
+        other.data = nullptr;
+        other.size = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+bool SourceBuffer::open(const std::string& path) {
+    release();
+    filename = path;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // mmap rejects zero-length mappings, an empty file is just an empty view
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+    madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+    data = static_cast<const char*>(mem);
+    size = st.st_size;
+    mapped = true;
+    return true;
+}
+
+void SourceBuffer::release() {
+    if (mapped) {
+        munmap(const_cast<char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
@@ -0,0 +1,48 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Read-only view of a source file, memory-mapped once and kept alive
+ *        for as long as tokens and AST nodes point into it
+ */
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+    /**
+     * @brief Function to map a file into memory
+     * @param filename Path of the file
+     * @return true on success, false if the file could not be opened or mapped
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Function to get the whole source text
+     * @return View over the mapped bytes, valid until the buffer is destroyed
+     */
+    std::string_view text() const { return std::string_view(data, size); }
+
+    /**
+     * @brief Function to get the name the buffer was opened with
+     */
+    const std::string& name() const { return filename; }
+
+private:
+    void release();
+
+    std::string filename;
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+};
+
+#endif // SOURCE_BUFFER_H
@@ -0,0 +1,76 @@
+#include "target.h"
+#include "../logger/logger.h"
+#include <llvm/ADT/StringMap.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetOptions.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+void initializeNativeTarget() {
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    });
+}
+
+llvm::CodeGenOpt::Level codeGenLevel(OptLevel level) {
+    switch (level) {
+        case OptLevel::O0: return llvm::CodeGenOpt::None;
+        case OptLevel::O1: return llvm::CodeGenOpt::Less;
+        case OptLevel::O2: return llvm::CodeGenOpt::Default;
+        case OptLevel::O3: return llvm::CodeGenOpt::Aggressive;
+    }
+    return llvm::CodeGenOpt::Default;
+}
+
+static const std::string& hostFeatures() {
+    static const std::string features = [] {
+        llvm::StringMap<bool> hostFeatureMap;
+        std::vector<std::string> enabled;
+        if (llvm::sys::getHostCPUFeatures(hostFeatureMap)) {
+            for (const auto& feature : hostFeatureMap) {
+                enabled.push_back((feature.second ? "+" : "-") + feature.first().str());
+            }
+        }
+        // StringMap iteration order is unspecified, sort so the string is stable across runs
+        std::sort(enabled.begin(), enabled.end());
+        std::string joined;
+        for (const std::string& feature : enabled) {
+            if (!joined.empty()) joined += ",";
+            joined += feature;
+        }
+        return joined;
+    }();
+    return features;
+}
+
+std::unique_ptr<llvm::TargetMachine> createHostTargetMachine(OptLevel level) {
+    initializeNativeTarget();
+
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    std::string error;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (!target) {
+        log::error("Failed to look up target {}: {}", triple, error);
+        return nullptr;
+    }
+
+    llvm::TargetOptions targetOptions;
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+        triple, llvm::sys::getHostCPUName(), hostFeatures(), targetOptions, llvm::Reloc::PIC_, llvm::None,
+        codeGenLevel(level)));
+}
+
+std::string hostTargetDescription() {
+    return llvm::sys::getDefaultTargetTriple() + ";" + llvm::sys::getHostCPUName().str() + ";" + hostFeatures();
+}
+
+void configureModuleForTarget(llvm::Module& module, llvm::TargetMachine& targetMachine) {
+    module.setTargetTriple(targetMachine.getTargetTriple().str());
+    module.setDataLayout(targetMachine.createDataLayout());
+}
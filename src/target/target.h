@@ -0,0 +1,40 @@
+#ifndef TARGET_H
+#define TARGET_H
+
+#include "../optimizer/optimizer.h"
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Function to register the native target with LLVM, safe to call repeatedly
+ */
+void initializeNativeTarget();
+
+/**
+ * @brief Function to get the backend optimization level matching an optimization level
+ */
+llvm::CodeGenOpt::Level codeGenLevel(OptLevel level);
+
+/**
+ * @brief Function to create a TargetMachine for the host CPU and its features
+ * @param level Optimization level used for code generation
+ * @return TargetMachine, or null if the host target is unavailable
+ */
+std::unique_ptr<llvm::TargetMachine> createHostTargetMachine(OptLevel level);
+
+/**
+ * @brief Function to describe the host target, triple, CPU and features
+ * @return Stable string that changes whenever generated code would
+ */
+std::string hostTargetDescription();
+
+/**
+ * @brief Function to stamp the target triple and data layout onto a module
+ * @param module Module to configure
+ * @param targetMachine Target the module will be compiled for
+ */
+void configureModuleForTarget(llvm::Module& module, llvm::TargetMachine& targetMachine);
+
+#endif // TARGET_H
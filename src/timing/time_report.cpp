@@ -0,0 +1,164 @@
+#include "time_report.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sys/resource.h>
+
+// thread_local so concurrent compiles do not contend on them
+static thread_local AllocationCounters counters;
+
+AllocationCounters threadAllocations() {
+    return counters;
+}
+
+void countAllocation(std::size_t bytes) {
+    ++counters.allocations;
+    counters.bytes += bytes;
+}
+
+static double wallMilliseconds() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double threadCpuMilliseconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static long peakRssKilobytes() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // kilobytes on Linux
+}
+
+// innermost phase measured on this thread
+static thread_local TimeReport::Scope* activeScope = nullptr;
+
+TimeReport::Scope::Scope(TimeReport* report, const char* name) : report(report), name(name) {
+    if (report) {
+        outer = activeScope;
+        activeScope = this;
+        allocationsStart = threadAllocations();
+        cpuStart = threadCpuMilliseconds();
+        wallStart = wallMilliseconds();
+    }
+}
+
+TimeReport::Scope::~Scope() {
+    if (!report) return;
+    double wallEnd = wallMilliseconds();
+    double cpuEnd = threadCpuMilliseconds();
+    AllocationCounters allocationsEnd = threadAllocations();
+    activeScope = outer;
+
+    // the workers were joined before the phase ended, their totals are final
+    std::lock_guard<std::mutex> lock(workersMutex);
+    Phase phase;
+    phase.name = name;
+    phase.wallMs = wallEnd - wallStart;
+    phase.cpuMs = cpuEnd - cpuStart + workersCpuMs;
+    phase.allocations = allocationsEnd.allocations - allocationsStart.allocations + workersAllocations.allocations;
+    phase.allocatedBytes = allocationsEnd.bytes - allocationsStart.bytes + workersAllocations.bytes;
+    phase.peakRssKb = peakRssKilobytes();
+    report->phases.push_back(std::move(phase));
+}
+
+TimeReport::Scope* TimeReport::Scope::current() {
+    return activeScope;
+}
+
+TimeReport::Worker::Worker(Scope* phase) : phase(phase) {
+    if (phase) {
+        allocationsStart = threadAllocations();
+        cpuStart = threadCpuMilliseconds();
+    }
+}
+
+TimeReport::Worker::~Worker() {
+    if (!phase) return;
+    double cpuEnd = threadCpuMilliseconds();
+    AllocationCounters allocationsEnd = threadAllocations();
+    std::lock_guard<std::mutex> lock(phase->workersMutex);
+    phase->workersCpuMs += cpuEnd - cpuStart;
+    phase->workersAllocations.allocations += allocationsEnd.allocations - allocationsStart.allocations;
+    phase->workersAllocations.bytes += allocationsEnd.bytes - allocationsStart.bytes;
+}
+
+void TimeReport::setCount(const char* name, uint64_t value) {
+    if (!enabled) return;
+    for (auto& count : counts) {
+        if (std::string(count.first) == name) {
+            count.second = value;
+            return;
+        }
+    }
+    counts.emplace_back(name, value);
+}
+
+static void printJSONString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void TimeReport::print(std::ostream& out, const std::string& input, TimeReportFormat format) const {
+    if (!enabled || format == TimeReportFormat::None) return;
+
+    double totalWall = 0, totalCpu = 0;
+    uint64_t totalAllocations = 0, totalBytes = 0;
+    for (const Phase& phase : phases) {
+        totalWall += phase.wallMs;
+        totalCpu += phase.cpuMs;
+        totalAllocations += phase.allocations;
+        totalBytes += phase.allocatedBytes;
+    }
+
+    if (format == TimeReportFormat::JSON) {
+        out << std::fixed << std::setprecision(3) << "{\"input\":";
+        printJSONString(out, input);
+        out << ",\"phases\":[";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            const Phase& phase = phases[i];
+            out << (i ? "," : "") << "{\"name\":\"" << phase.name << "\",\"wall_ms\":" << phase.wallMs
+                << ",\"cpu_ms\":" << phase.cpuMs << ",\"allocations\":" << phase.allocations
+                << ",\"allocated_bytes\":" << phase.allocatedBytes << ",\"peak_rss_kb\":" << phase.peakRssKb << "}";
+        }
+        out << "],\"counts\":{";
+        for (size_t i = 0; i < counts.size(); ++i) {
+            out << (i ? "," : "") << "\"" << counts[i].first << "\":" << counts[i].second;
+        }
+        out << "},\"total\":{\"wall_ms\":" << totalWall << ",\"cpu_ms\":" << totalCpu
+            << ",\"allocations\":" << totalAllocations << ",\"allocated_bytes\":" << totalBytes
+            << ",\"peak_rss_kb\":" << peakRssKilobytes() << "}}\n";
+        return;
+    }
+
+    out << "===== Time report: " << input << " =====\n";
+    out << std::left << std::setw(12) << "phase" << std::right << std::setw(12) << "wall ms" << std::setw(12)
+        << "cpu ms" << std::setw(12) << "allocs" << std::setw(14) << "alloc bytes" << std::setw(14) << "peak RSS KB"
+        << "\n";
+    out << std::fixed << std::setprecision(3);
+    for (const Phase& phase : phases) {
+        out << std::left << std::setw(12) << phase.name << std::right << std::setw(12) << phase.wallMs << std::setw(12)
+            << phase.cpuMs << std::setw(12) << phase.allocations << std::setw(14) << phase.allocatedBytes
+            << std::setw(14) << phase.peakRssKb << "\n";
+    }
+    out << std::left << std::setw(12) << "total" << std::right << std::setw(12) << totalWall << std::setw(12)
+        << totalCpu << std::setw(12) << totalAllocations << std::setw(14) << totalBytes << std::setw(14)
+        << peakRssKilobytes() << "\n";
+    for (const auto& count : counts) {
+        out << count.first << ": " << count.second << "\n";
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class TimeReportFormat {
+    None,
+    Text,
+    JSON
+};
+
+/**
+ * @brief Allocation counters of the calling thread, maintained by the global operator new of
+ *        alloc_counter.cpp; they stay zero in programs that do not link it, such as libnova's
+ */
+struct AllocationCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Function to read the calling thread's allocation counters
+ */
+AllocationCounters threadAllocations();
+
+/**
+ * @brief Function to count an allocation of the calling thread
+ */
+void countAllocation(std::size_t bytes);
+
+/**
+ * @brief Per-phase wall time, CPU time, allocations and peak RSS of one compile
+ */
+class TimeReport {
+public:
+    struct Phase {
+        std::string name;
+        double wallMs = 0;
+        double cpuMs = 0;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        long peakRssKb = 0;
+    };
+
+    class Worker;
+
+    /**
+     * @brief Measures one phase from construction to destruction, on the calling thread and
+     *        on the worker threads that report to it through Worker
+     */
+    class Scope {
+    public:
+        Scope(TimeReport* report, const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        /**
+         * @brief Function to get the innermost phase measured on the calling thread
+         * @return Phase, null if there is none or the report is disabled
+         */
+        static Scope* current();
+
+    private:
+        friend class Worker;
+
+        TimeReport* report;
+        const char* name;
+        Scope* outer = nullptr;
+        double wallStart = 0;
+        double cpuStart = 0;
+        AllocationCounters allocationsStart;
+        std::mutex workersMutex; // guards the totals the workers add
+        double workersCpuMs = 0;
+        AllocationCounters workersAllocations;
+    };
+
+    /**
+     * @brief Measures a task another thread runs for a phase, from construction to
+     *        destruction, and adds its CPU time and allocations to the phase. Created on the
+     *        worker; the phase must still be open when it is destroyed, as it is for pools
+     *        joined inside the phase.
+     */
+    class Worker {
+    public:
+        /**
+         * @param phase Phase the task belongs to, Scope::current() where it was submitted; null measures nothing
+         */
+        explicit Worker(Scope* phase);
+        ~Worker();
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+    private:
+        Scope* phase;
+        double cpuStart = 0;
+        AllocationCounters allocationsStart;
+    };
+
+    explicit TimeReport(bool enabled) : enabled(enabled) {}
+
+    bool isEnabled() const { return enabled; }
+
+    /**
+     * @brief Function to start measuring a phase, ends when the returned scope is destroyed
+     * @param name Phase name, must be a string literal
+     */
+    Scope phase(const char* name) { return Scope(enabled ? this : nullptr, name); }
+
+    /**
+     * @brief Function to record a size metric such as the token count
+     */
+    void setCount(const char* name, uint64_t value);
+
+    /**
+     * @brief Function to print the report, JSON is one object per line
+     * @param out Stream to print to
+     * @param input Input file the report belongs to
+     * @param format Text or JSON
+     */
+    void print(std::ostream& out, const std::string& input, TimeReportFormat format) const;
+
+private:
+    bool enabled;
+    std::vector<Phase> phases;
+    std::vector<std::pair<const char*, uint64_t>> counts;
+};
+
+#endif // TIME_REPORT_H
@@ -1,102 +1,240 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
-#include <cctype>
+#include <cstdint>
+#include <cstring>
 #include "tokenize.h"
 
-const std::unordered_map<std::string, TokenType> KEYWORDS = {
-    {"fn", TokenType::KEYWORD},
-    {"let", TokenType::KEYWORD},
-    {"return", TokenType::KEYWORD},
-    {"int", TokenType::KEYWORD}
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum CharClass : uint8_t {
+    OTHER,
+    SPACE,
+    NEWLINE,
+    SYMBOL,
+    IDENT_START, // letters and '_'
+    DIGIT
 };
 
-const std::unordered_map<char, TokenType> SYMBOLS = {
-    {'=', TokenType::SYMBOL},
-    {'+', TokenType::SYMBOL},
-    {'-', TokenType::SYMBOL},
-    {'*', TokenType::SYMBOL},
-    {'/', TokenType::SYMBOL},
-    {'(', TokenType::SYMBOL},
-    {')', TokenType::SYMBOL},
-    {'{', TokenType::SYMBOL},
-    {'}', TokenType::SYMBOL},
-    {',', TokenType::SYMBOL},
-    {':', TokenType::SYMBOL},
-    {';', TokenType::SYMBOL}
+struct CharTable {
+    CharClass classes[256];
+
+    constexpr CharTable() : classes() {
+        for (int c = 'a'; c <= 'z'; ++c) classes[c] = IDENT_START;
+        for (int c = 'A'; c <= 'Z'; ++c) classes[c] = IDENT_START;
+        classes[static_cast<unsigned char>('_')] = IDENT_START;
+        for (int c = '0'; c <= '9'; ++c) classes[c] = DIGIT;
+        for (char c : {' ', '\t', '\r', '\v', '\f'}) classes[static_cast<unsigned char>(c)] = SPACE;
+        classes[static_cast<unsigned char>('\n')] = NEWLINE;
+        for (char c : {'=', '+', '-', '*', '/', '(', ')', '{', '}', '[', ']', ',', ':', ';', '<', '>', '!'}) {
+            classes[static_cast<unsigned char>(c)] = SYMBOL;
+        }
+    }
 };
 
+constexpr CharTable CHAR_TABLE;
 
-std::vector<Token> tokenize(const std::string& content) {
-    std::vector<Token> tokens;
-    int line = 1, column = 1;
+inline CharClass classOf(char c) {
+    return CHAR_TABLE.classes[static_cast<unsigned char>(c)];
+}
 
-    for (size_t i = 0; i < content.length(); ++i) {
-        char c = content[i];
+inline bool isIdentifierChar(char c) {
+    CharClass cls = classOf(c);
+    return cls == IDENT_START || cls == DIGIT;
+}
 
-        if (c == '/' && i + 1 < content.length() && content[i + 1] == '/') {
-            // skip until the end of the line or the end of the content
-            while (i < content.length() && content[i] != '\n') {
-                i++;
-            }
-            line++;
-            column = 1;
-            continue;
-        }
+/**
+ * @brief Function to classify an identifier, every keyword is checked with one length/first-char switch
+ */
+TokenType keywordOrIdentifier(std::string_view word) {
+    switch (word.size()) {
+        case 2:
+            if (word[0] == 'f') return word == "fn" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+            if (word[0] == 'i') return word == "if" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+            return TokenType::IDENTIFIER;
+        case 3:
+            if (word[0] == 'l') return word == "let" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+            if (word[0] == 'i') return word == "int" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+            if (word[0] == 'f') return word == "for" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+            return TokenType::IDENTIFIER;
+        case 4: return word == "else" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+        case 5: return word == "while" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+        case 6: return word == "return" ? TokenType::KEYWORD : TokenType::IDENTIFIER;
+        default: return TokenType::IDENTIFIER;
+    }
+}
 
-        // handle whitespace
-        if (std::isspace(c)) {
-            if (c == '\n') {
-                line++;
-                column = 1;
-            } else {
-                column++;
-            }
-            continue;
-        }
+#if defined(__SSE2__)
+// bit i is set when byte i of the block lies in [low, low + count)
+inline unsigned rangeMask(__m128i block, char low, char count) {
+    __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8(static_cast<char>(low + 128)));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(count - 128)))));
+}
 
-        // handle symbols
-        if (SYMBOLS.count(c)) {
-            tokens.push_back({SYMBOLS.at(c), std::string(1, c), line, column});
-            column++;
-            continue;
-        }
+inline unsigned identifierMask(__m128i block) {
+    __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20)); // folds A-Z onto a-z
+    return rangeMask(lower, 'a', 26) | rangeMask(block, '0', 10) |
+           static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('_'))));
+}
+#endif
 
-        // handle keywords and identifiers
-        if (std::isalpha(c) || c == '_') {
-            std::string identifier(1, c);
-            while (i + 1 < content.length() && (std::isalnum(content[i + 1]) || content[i + 1] == '_')) {
-                identifier += content[++i];
-            }
+/**
+ * @brief Function to find the end of an identifier run starting at i
+ */
+size_t skipIdentifier(std::string_view content, size_t i) {
+#if defined(__SSE2__)
+    while (i + 16 <= content.size()) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(content.data() + i));
+        unsigned stop = ~identifierMask(block) & 0xFFFF;
+        if (stop) return i + __builtin_ctz(stop);
+        i += 16;
+    }
+#endif
+    while (i < content.size() && isIdentifierChar(content[i])) ++i;
+    return i;
+}
 
-            TokenType type = KEYWORDS.count(identifier) ? KEYWORDS.at(identifier) : TokenType::IDENTIFIER;
-            tokens.push_back({type, identifier, line, column});
-            column += identifier.length();
-            continue;
+/**
+ * @brief Function to skip whitespace starting at i, counting the newlines crossed
+ * @param lineStart Updated to the offset just past the last newline crossed
+ */
+size_t skipWhitespace(std::string_view content, size_t i, int& line, size_t& lineStart) {
+#if defined(__SSE2__)
+    while (i + 16 <= content.size()) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(content.data() + i));
+        unsigned newlines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+        unsigned spaces = newlines | rangeMask(block, '\t', 5) | // \t \n \v \f \r
+                          static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(' '))));
+        unsigned stop = ~spaces & 0xFFFF;
+        unsigned run = stop ? static_cast<unsigned>(__builtin_ctz(stop)) : 16;
+        unsigned crossed = newlines & ((1u << run) - 1);
+        if (crossed) {
+            line += __builtin_popcount(crossed);
+            lineStart = i + (31 - __builtin_clz(crossed)) + 1;
+        }
+        i += run;
+        if (stop) return i;
+    }
+#endif
+    for (; i < content.size(); ++i) {
+        CharClass cls = classOf(content[i]);
+        if (cls == NEWLINE) {
+            ++line;
+            lineStart = i + 1;
+        } else if (cls != SPACE) {
+            break;
         }
+    }
+    return i;
+}
+
+} // namespace
+
+bool Lexer::lexToken(Token& token) {
+    const size_t size = content.size();
+    size_t i = position;
+
+    while (i < size) {
+        char c = content[i];
+        int column = static_cast<int>(i - lineStart) + 1;
+
+        switch (classOf(c)) {
+            case SPACE:
+                // single spaces between tokens are the common case, leave runs to the vector scan
+                if (i + 1 < size && classOf(content[i + 1]) > NEWLINE) {
+                    ++i;
+                    break;
+                }
+                i = skipWhitespace(content, i, line, lineStart);
+                break;
+
+            case NEWLINE:
+                i = skipWhitespace(content, i, line, lineStart);
+                break;
+
+            case SYMBOL:
+                if (c == '/' && i + 1 < size && content[i + 1] == '/') {
+                    // skip until the end of the line or the end of the content
+                    const void* newline = std::memchr(content.data() + i, '\n', size - i);
+                    if (!newline) {
+                        i = size;
+                        break;
+                    }
+                    i = static_cast<const char*>(newline) - content.data() + 1;
+                    ++line;
+                    lineStart = i;
+                    break;
+                }
+                // ==, !=, <= and >= are the only two-character symbols
+                if ((c == '=' || c == '!' || c == '<' || c == '>') && i + 1 < size && content[i + 1] == '=') {
+                    token = {TokenType::SYMBOL, content.substr(i, 2), line, column};
+                    position = i + 2;
+                    return true;
+                }
+                token = {TokenType::SYMBOL, content.substr(i, 1), line, column};
+                position = i + 1;
+                return true;
+
+            case IDENT_START: {
+                size_t end = skipIdentifier(content, i + 1);
+                std::string_view identifier = content.substr(i, end - i);
+                token = {keywordOrIdentifier(identifier), identifier, line, column};
+                position = end;
+                return true;
+            }
 
-        // handle numbers
-        if (std::isdigit(c)) {
-            std::string number(1, c);
-            while (i + 1 < content.length() && std::isdigit(content[i + 1])) {
-                number += content[++i];
+            case DIGIT: {
+                size_t end = i + 1;
+                while (end < size && classOf(content[end]) == DIGIT) ++end;
+                token = {TokenType::NUMBER, content.substr(i, end - i), line, column};
+                position = end;
+                return true;
             }
-            tokens.push_back({TokenType::NUMBER, number, line, column});
-            column += number.length();
-            continue;
+
+            case OTHER:
+                // fallback for unknown tokens
+                token = {TokenType::UNKNOWN, content.substr(i, 1), line, column};
+                position = i + 1;
+                return true;
         }
+    }
 
-        // fallback for unknown tokens
-        tokens.push_back({TokenType::UNKNOWN, std::string(1, c), line, column});
-        column++;
+    position = size;
+    token = {TokenType::END_OF_FILE, content.substr(size), line, static_cast<int>(size - lineStart) + 1};
+    return false;
+}
+
+void Lexer::fill() {
+    Token& slot = ring[(head + buffered) % LOOKAHEAD];
+    if (lexToken(slot)) {
+        ++produced;
     }
+    ++buffered;
+}
 
+std::vector<Token> tokenize(std::string_view content) {
+    std::vector<Token> tokens;
+    tokenize(content, tokens);
     return tokens;
 }
 
+void tokenize(std::string_view content, std::vector<Token>& tokens) {
+    tokens.clear();
+    tokens.reserve(content.length() / 2); // rough guess, dense code averages under 3 bytes per token
+    Lexer lexer(content);
+    Token token;
+    while (lexer.lexToken(token)) {
+        tokens.push_back(token);
+    }
+}
+
 void print_tokens(const std::vector<Token>& tokens) {
     for (const auto& token : tokens) {
         std::cout << token.to_string() << std::endl;
     }
-}
\ No newline at end of file
+}
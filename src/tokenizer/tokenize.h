@@ -2,6 +2,7 @@
 #define TOKENIZE_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <cctype>
@@ -13,12 +14,13 @@ enum class TokenType {
     NUMBER,
     SYMBOL,
     WHITESPACE,
-    UNKNOWN
+    UNKNOWN,
+    END_OF_FILE
 };
 
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value; // points into the SourceBuffer the token was lexed from
     int line;
     int column;
 
@@ -31,18 +33,95 @@ struct Token {
             case TokenType::SYMBOL: type_str = "SYMBOL"; break;
             case TokenType::WHITESPACE: type_str = "WHITESPACE"; break;
             case TokenType::UNKNOWN: type_str = "UNKNOWN"; break;
+            case TokenType::END_OF_FILE: type_str = "END_OF_FILE"; break;
         }
-        return "Token(" + type_str + ", \"" + value + "\", " +
+        return "Token(" + type_str + ", \"" + std::string(value) + "\", " +
                std::to_string(line) + ", " + std::to_string(column) + ")";
     }
 };
 
+/**
+ * @brief Pull-based lexer, tokens are produced on demand with a small lookahead window
+ *        so no caller has to hold the whole token stream
+ */
+class Lexer {
+public:
+    static constexpr size_t LOOKAHEAD = 4;
+
+    /**
+     * @param content Content to tokenize, must outlive the lexer and its tokens
+     */
+    explicit Lexer(std::string_view content) : content(content) {}
+
+    /**
+     * @brief Function to look at an upcoming token without consuming it
+     * @param ahead Tokens to skip, less than LOOKAHEAD
+     * @return Token, END_OF_FILE past the end; valid until the next consume()
+     */
+    const Token& peek(size_t ahead = 0) {
+        while (buffered <= ahead) fill();
+        return ring[(head + ahead) % LOOKAHEAD];
+    }
+
+    /**
+     * @brief Function to consume the next token
+     * @return Token, valid until LOOKAHEAD - 1 further tokens have been peeked
+     */
+    const Token& consume() {
+        if (!buffered) fill();
+        const Token& token = ring[head];
+        head = (head + 1) % LOOKAHEAD;
+        --buffered;
+        return token;
+    }
+
+    /**
+     * @brief Function to get the number of tokens lexed so far, END_OF_FILE excluded
+     */
+    size_t tokenCount() const { return produced; }
+
+    /**
+     * @brief Function to get the content being lexed, token values point into it
+     */
+    std::string_view source() const { return content; }
+
+private:
+    friend void tokenize(std::string_view content, std::vector<Token>& tokens);
+
+    /**
+     * @brief Function to lex the next token straight from the content
+     * @return false at the end of the content, token is then END_OF_FILE
+     */
+    bool lexToken(Token& token);
+    /**
+     * @brief Function to append one token to the lookahead window
+     */
+    void fill();
+
+    std::string_view content;
+    size_t position = 0;
+    int line = 1;
+    size_t lineStart = 0; // columns are derived from the offset of the current line
+
+    Token ring[LOOKAHEAD];
+    size_t head = 0;
+    size_t buffered = 0;
+    size_t produced = 0;
+};
+
 /**
  * @brief Function to tokenize the content
- * @param content Content to tokenize
- * @return Vector of tokens
+ * @param content Content to tokenize, must outlive the returned tokens
+ * @return Vector of tokens viewing into content
+ */
+std::vector<Token> tokenize(std::string_view content);
+
+/**
+ * @brief Function to tokenize the content into an existing vector, reusing its capacity
+ * @param content Content to tokenize, must outlive the tokens
+ * @param tokens Cleared, then filled with the tokens of content
  */
-std::vector<Token> tokenize(const std::string& content);
+void tokenize(std::string_view content, std::vector<Token>& tokens);
 
 /**
  * @brief Function to print tokens
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Compiles every program in tests/diagnostics, each has syntax errors, and checks that cts
+# reports as many errors as the program's "// errors: N" line expects, so recovery neither
+# skips nor invents any.
+# Usage: tests/run_diagnostics.sh [path to cts]
+
+CTS=${1:-./cts}
+DIR=$(dirname "$0")/diagnostics
+failed=0
+
+for program in "$DIR"/*.nv; do
+    expected=$(sed -n 's|^// errors: \([0-9]*\)$|\1|p' "$program")
+    output=$("$CTS" --run "$program" 2>&1)
+    status=$?
+    actual=$(printf '%s\n' "$output" | sed -n 's/^\([0-9]*\) errors\{0,1\} generated\.$/\1/p')
+    if [ $status -ne 0 ] && [ $status -lt 128 ] && [ "$actual" = "$expected" ]; then
+        echo "ok   $(basename "$program"): $actual errors"
+    else
+        echo "FAIL $(basename "$program"): status $status, ${actual:-no} errors, expected $expected"
+        printf '%s\n' "$output" | grep "error:"
+        failed=1
+    fi
+done
+
+exit $failed
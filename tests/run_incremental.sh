@@ -0,0 +1,65 @@
+#!/bin/sh
+# Builds tests/incremental/program.nv with --incremental at -O0 and -O2, edits one function and
+# checks that only it is rebuilt, that the result equals a build without saved state and that
+# main returns what a full build returns. A compile that fails must not save its state.
+# Usage: tests/run_incremental.sh [path to cts]
+
+CTS=${1:-./cts}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failed=0
+
+fail() {
+    echo "FAIL $*"
+    failed=1
+}
+
+# functions rebuilt by an incremental compile, the remaining arguments go to cts
+rebuilt() {
+    "$CTS" --incremental --time-report "$@" 2>&1 | sed -n 's/^functions_rebuilt: //p'
+}
+
+# what main returns, or the error that stopped it
+returned() {
+    "$CTS" --run "$@" 2>&1 | sed -n 's/.*main returned \(-\{0,1\}[0-9]*\),.*/\1/p; s/.*Runtime error[^:]*: //p'
+}
+
+for level in -O0 -O2; do
+    cp "$(dirname "$0")/incremental/program.nv" "$WORK/program.nv"
+    rm -f "$WORK"/*.nvinc
+
+    count=$(rebuilt $level -o "$WORK/out.ll" "$WORK/program.nv")
+    [ "$count" = 5 ] || fail "$level first build rebuilt ${count:-nothing}, expected 5"
+    cp "$WORK/out.ll" "$WORK/first.ll"
+    count=$(rebuilt $level -o "$WORK/out.ll" "$WORK/program.nv")
+    [ "$count" = 0 ] || fail "$level unchanged build rebuilt ${count:-nothing}, expected 0"
+    cmp -s "$WORK/out.ll" "$WORK/first.ll" || fail "$level unchanged build changed the output"
+
+    sed 's/return x \* x;/return x * x + 1;/' "$WORK/program.nv" > "$WORK/edited.nv"
+    mv "$WORK/edited.nv" "$WORK/program.nv"
+    count=$(rebuilt $level -o "$WORK/out.ll" "$WORK/program.nv")
+    [ "$count" = 1 ] || fail "$level build after editing sq rebuilt ${count:-nothing}, expected 1"
+
+    # no saved state, every function is compiled
+    "$CTS" --incremental $level -o "$WORK/fresh.ll" "$WORK/program.nv" >/dev/null 2>&1
+    cmp -s "$WORK/out.ll" "$WORK/fresh.ll" || fail "$level output after the edit differs from a build without state"
+    if [ $level = -O0 ]; then
+        "$CTS" $level -o "$WORK/full.ll" "$WORK/program.nv" >/dev/null 2>&1
+        cmp -s "$WORK/out.ll" "$WORK/full.ll" || fail "$level output differs from a full build"
+    fi
+
+    full=$(returned $level "$WORK/program.nv")
+    incremental=$(returned --incremental $level -o "$WORK/out.ll" "$WORK/program.nv")
+    [ -n "$full" ] && [ "$incremental" = "$full" ] || fail "$level main returned ${incremental:-nothing}, a full build ${full:-nothing}"
+
+    # sq now divides by zero at run time, the failed --run keeps the previous state
+    sed 's/return x \* x + 1;/return x * x \/ (x - x);/' "$WORK/program.nv" > "$WORK/edited.nv"
+    mv "$WORK/edited.nv" "$WORK/program.nv"
+    returned --incremental $level -o "$WORK/out.ll" "$WORK/program.nv" >/dev/null
+    count=$(rebuilt $level -o "$WORK/out.ll" "$WORK/program.nv")
+    [ "$count" = 1 ] || fail "$level build after a failed run rebuilt ${count:-nothing}, expected 1"
+
+    [ $failed = 0 ] && echo "ok   incremental $level"
+done
+
+exit $failed
@@ -0,0 +1,135 @@
+#!/bin/sh
+# Writes tests/ast/program.nv as an AST file, damages one node of a copy at a time and checks
+# that cts rejects every damaged file as malformed instead of crashing.
+# Usage: tests/run_malformed_ast.sh [path to cts]
+
+CTS=${1:-./cts}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failed=0
+
+# SerializedNode records follow the 24-byte header, 32 bytes each, SerializedSymbol records
+# follow the nodes, 40 bytes each
+HEADER=24
+NODE=32
+SYMBOL_RECORD=40
+NAME=0
+NAME_LENGTH=4
+KIND=0
+VALUE_LENGTH=12
+SYMBOL=16
+NUMBER=20
+FIRST_CHILD=24
+
+if ! "$CTS" --emit=ast -o "$WORK/program.nvast" "$(dirname "$0")/ast/program.nv" >/dev/null 2>&1; then
+    echo "FAIL could not write the AST file"
+    exit 1
+fi
+NODES=$(od -An -t u4 -j 8 -N 4 "$WORK/program.nvast" | tr -d ' ')
+
+read_field() { # node offset
+    od -An -t d4 -j $((HEADER + NODE * $1 + $2)) -N 4 "$WORK/program.nvast" | tr -d ' '
+}
+
+# file position of a field of a symbol record
+symbol_field() { # slot offset
+    echo $((HEADER + NODE * NODES + SYMBOL_RECORD * $1 + $2))
+}
+
+read_symbol_field() { # slot offset
+    od -An -t d4 -j "$(symbol_field "$1" "$2")" -N 4 "$WORK/program.nvast" | tr -d ' '
+}
+
+# index of the nth node (1-based) of a NodeKind
+find_node() { # kind nth
+    seen=0
+    i=0
+    while [ $i -lt "$NODES" ]; do
+        if [ "$(od -An -t u1 -j $((HEADER + NODE * i)) -N 1 "$WORK/program.nvast" | tr -d ' ')" = "$1" ]; then
+            seen=$((seen + 1))
+            if [ $seen = "$2" ]; then
+                echo $i
+                return
+            fi
+        fi
+        i=$((i + 1))
+    done
+    echo "no node of kind $1" >&2
+    exit 1
+}
+
+write_bytes() { # file position count value, little endian
+    v=$(( $4 & 0xffffffff ))
+    bytes=""
+    n=0
+    while [ $n -lt "$3" ]; do
+        bytes="$bytes$(printf '\\%03o' $(( (v >> (8 * n)) & 255 )))"
+        n=$((n + 1))
+    done
+    # shellcheck disable=SC2059
+    printf "$bytes" | dd of="$1" bs=1 seek="$2" conv=notrunc 2>/dev/null
+}
+
+# name: expects the damaged copy $WORK/<name>.nvast to be rejected
+rejected() {
+    output=$("$CTS" --run "$WORK/$1.nvast" 2>&1)
+    status=$?
+    if [ $status -ne 0 ] && [ $status -lt 128 ] && printf '%s\n' "$output" | grep -q "Malformed AST file"; then
+        echo "ok   $1: $(printf '%s\n' "$output" | sed -n 's/.*Malformed AST file: //p' | head -n 1)"
+    else
+        echo "FAIL $1: status $status"
+        printf '%s\n' "$output" | tail -n 3
+        failed=1
+    fi
+}
+
+# name node offset size value: copies the file, writes value into one field of a node and
+# expects the copy to be rejected
+damaged() {
+    cp "$WORK/program.nvast" "$WORK/$1.nvast"
+    write_bytes "$WORK/$1.nvast" $((HEADER + NODE * $2 + $3)) "$4" "$5"
+    rejected "$1"
+}
+
+FUNCTION=$(find_node 1 1)
+MAIN=$(find_node 1 2)
+DECLARATION=$(find_node 3 3)
+VARIABLE=$(find_node 8 1)
+INDEX=$(find_node 10 1)
+OPERATOR=$(find_node 6 1)
+RETURN=$(find_node 5 1)
+CALL=$(find_node 9 1)
+# a[2] = 5 in main, the index is a literal
+INDEX_LITERAL=$((INDEX + $(read_field "$INDEX" $FIRST_CHILD)))
+
+# NodeKind values: Function 1, VariableDeclaration 3, ReturnStatement 5, BinaryOp 6, Variable 8,
+# Call 9, Index 10, Block 12
+damaged function_without_symbol "$FUNCTION" $SYMBOL 4 -1
+damaged function_of_variable "$FUNCTION" $SYMBOL 4 "$(read_field "$VARIABLE" $SYMBOL)"
+damaged variable_without_symbol "$VARIABLE" $SYMBOL 4 -1
+damaged variable_of_function "$VARIABLE" $SYMBOL 4 "$(read_field "$FUNCTION" $SYMBOL)"
+damaged index_of_int "$INDEX" $SYMBOL 4 "$(read_field "$DECLARATION" $SYMBOL)"
+damaged index_out_of_bounds "$INDEX_LITERAL" $NUMBER 4 50000000
+damaged operator_missing "$OPERATOR" $VALUE_LENGTH 4 0
+damaged return_as_block "$RETURN" $KIND 1 12
+damaged call_with_wrong_arity "$CALL" $SYMBOL 4 "$(read_field "$MAIN" $SYMBOL)"
+
+# sum and main trade names, so main takes sum's two parameters
+SUM_SLOT=$(read_field "$FUNCTION" $SYMBOL)
+MAIN_SLOT=$(read_field "$MAIN" $SYMBOL)
+cp "$WORK/program.nvast" "$WORK/main_with_parameters.nvast"
+for field in $NAME $NAME_LENGTH; do
+    write_bytes "$WORK/main_with_parameters.nvast" "$(symbol_field "$SUM_SLOT" $field)" 4 "$(read_symbol_field "$MAIN_SLOT" $field)"
+    write_bytes "$WORK/main_with_parameters.nvast" "$(symbol_field "$MAIN_SLOT" $field)" 4 "$(read_symbol_field "$SUM_SLOT" $field)"
+done
+rejected main_with_parameters
+
+output=$("$CTS" --run "$WORK/program.nvast" 2>&1)
+if printf '%s\n' "$output" | grep -q "main returned 1,"; then
+    echo "ok   undamaged file runs"
+else
+    echo "FAIL undamaged file: $output"
+    failed=1
+fi
+
+exit $failed
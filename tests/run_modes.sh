@@ -0,0 +1,70 @@
+#!/bin/sh
+# Runs every program in tests/modes in the interpreter and as native code at -O0 and -O2, and
+# checks that all modes agree: main returns the same value, or stops with the same runtime error.
+# Programs in tests/tier run in the interpreter with and without tier-up, and must tier up.
+# Every program must compile to the same -O2 IR on one and on three codegen threads.
+# Usage: tests/run_modes.sh [path to cts]
+
+CTS=${1:-./cts}
+DIR=$(dirname "$0")/modes
+failed=0
+
+# the result of one run, "returned N" or "error: <message>"
+outcome() {
+    output=$("$CTS" "$@" 2>&1)
+    status=$?
+    returned=$(printf '%s\n' "$output" | sed -n 's/.*main returned \(-\{0,1\}[0-9]*\),.*/\1/p')
+    error=$(printf '%s\n' "$output" | sed -n 's/.*Runtime error[^:]*: //p')
+    if [ -n "$returned" ]; then
+        echo "returned $returned"
+    elif [ -n "$error" ]; then
+        echo "error: $error"
+    else
+        echo "failed with status $status"
+    fi
+}
+
+for program in "$DIR"/*.nv; do
+    expected=$(outcome --interp --tier-up=0 "$program")
+    agreed=1
+    for mode in "--run -O0" "--run -O2"; do
+        # shellcheck disable=SC2086
+        actual=$(outcome $mode "$program")
+        if [ "$actual" != "$expected" ]; then
+            echo "FAIL $(basename "$program") $mode: $actual, the interpreter: $expected"
+            agreed=0
+            failed=1
+        fi
+    done
+    [ $agreed = 1 ] && echo "ok   $(basename "$program"): $expected"
+done
+
+for program in "$(dirname "$0")"/tier/*.nv; do
+    expected=$(outcome --interp --tier-up=0 "$program")
+    actual=$(outcome --interp --tier-up=1 "$program")
+    tiered=$("$CTS" --interp --tier-up=1 --time-report "$program" 2>&1 | sed -n 's/^functions_tiered_up: //p')
+    if [ "$actual" != "$expected" ]; then
+        echo "FAIL $(basename "$program") tiered up: $actual, the interpreter: $expected"
+        failed=1
+    elif [ "${tiered:-0}" -eq 0 ]; then
+        echo "FAIL $(basename "$program"): no function tiered up"
+        failed=1
+    else
+        echo "ok   $(basename "$program") tiered up: $expected"
+    fi
+done
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+for program in "$DIR"/*.nv "$(dirname "$0")"/tier/*.nv; do
+    "$CTS" -O2 --codegen-threads=1 -o "$OUT/one.ll" "$program" >/dev/null 2>&1
+    "$CTS" -O2 --codegen-threads=3 -o "$OUT/three.ll" "$program" >/dev/null 2>&1
+    if cmp -s "$OUT/one.ll" "$OUT/three.ll"; then
+        echo "ok   $(basename "$program"): same IR on 1 and 3 codegen threads"
+    else
+        echo "FAIL $(basename "$program"): IR differs between 1 and 3 codegen threads"
+        failed=1
+    fi
+done
+
+exit $failed
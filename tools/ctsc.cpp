@@ -0,0 +1,47 @@
+// Thin client for cts --server. Links no LLVM, so a compile forwarded through it
+// costs a process start of a few hundred microseconds instead of loading the compiler.
+// Takes the same command line as cts; without a listening server it runs cts itself.
+#include "../src/server/client.h"
+#include "../src/server/protocol.h"
+#include "../src/logger/logger.h"
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Function to get the path of the cts binary installed next to this one
+ */
+static std::string compilerPath() {
+    std::vector<char> self(4096);
+    ssize_t length = ::readlink("/proc/self/exe", self.data(), self.size() - 1);
+    if (length <= 0) return "cts";
+    std::string path(self.data(), length);
+    size_t slash = path.find_last_of('/');
+    return path.substr(0, slash + 1) + "cts";
+}
+
+int main(int argc, char** argv) {
+    std::string socketPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--socket=", 0) == 0) socketPath = argument.substr(9);
+    }
+    if (socketPath.empty()) socketPath = defaultSocketPath();
+
+    int status = 1;
+    if (runClient(socketPath, argc, argv, status)) {
+        return status;
+    }
+
+    // no server, compile in a process of our own with the same command line
+    std::string compiler = compilerPath();
+    std::vector<char*> arguments(argv, argv + argc);
+    arguments[0] = compiler.data();
+    arguments.push_back(nullptr);
+    ::execv(compiler.c_str(), arguments.data());
+    ::execvp("cts", arguments.data());
+    log::error("Failed to run {}: {}", compiler, std::strerror(errno));
+    return 1;
+}